@@ -0,0 +1,40 @@
+#!/bin/sh
+#
+# usage: make-dict.sh def|load|get|put entries > file.ps
+#
+# Writes a program that fills a dictionary of 'entries' names and then runs
+# the operation on every entry, over and over, a million times in all, so that
+# the times for different sizes compare. The names are written out since there
+# is no cvn. The dictionary is created at its final size, or at the largest
+# that dict accepts (MAX_OBJECT_SIZE), past which it grows. run-bench.sh times
+# it at 10, 1k and 100k entries.
+
+if [ $# -ne 2 ]; then
+	echo "usage: $0 def|load|get|put entries" >&2
+	exit 2
+fi
+
+case "$1" in
+def)	body='keys exch get 0 def' ;;
+load)	body='keys exch get load pop' ;;
+get)	body='keys exch get d exch get pop' ;;
+put)	body='keys exch get d exch 1 put' ;;
+*)	echo "$0: unknown operation: $1" >&2; exit 2 ;;
+esac
+
+entries=$2
+size=$((entries < 65536 ? entries : 65536))
+
+echo '%!PS'
+echo '/keys ['
+awk -v entries=$entries 'BEGIN {
+	for (i = 0; i < entries; i++)
+		print "/k" i
+}'
+echo '] def'
+echo "/d $size dict def"
+echo 'd begin'
+echo "0 1 $((entries - 1)) { keys exch get 0 def } for"
+echo "$((1000000 / entries)) { 0 1 $((entries - 1)) { $body } for } repeat"
+echo 'end'
+echo 'd length =='
@@ -0,0 +1,19 @@
+#!/bin/sh
+#
+# usage: make-hex.sh [megabytes] > file.ps
+#
+# Writes a program with a single hex string literal of 'megabytes' (10 by
+# default) megabytes of digits, in lines of 64 as inline image data would be.
+# run-bench.sh times it with the other programs.
+
+size=${1:-10}
+
+echo '%!PS'
+echo '<'
+awk -v lines=$((size * 1048576 / 64)) 'BEGIN {
+	line = "0123456789abcdefABCDEF0123456789fedcba9876543210FEDCBA9876543210"
+
+	for (i = 0; i < lines; i++)
+		print line
+}'
+echo '> length =='
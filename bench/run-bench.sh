@@ -0,0 +1,67 @@
+#!/bin/sh
+#
+# usage: run-bench.sh path/to/eps2img [runs]
+#
+# Converts each .ps file in this directory 'runs' times (7 by default) and
+# prints the best wall time in milliseconds. Build without the cairo output
+# (or with it stubbed) to time the interpreter alone. hex-literal.ps, a 10 MB
+# hex string, and the dict-*.ps dictionary programs are written by make-hex.sh
+# and make-dict.sh for the run and removed after it. The scanner alone (-scan)
+# is then timed on the samples and its best rate printed in tokens per second.
+
+if [ $# -lt 1 ]; then
+	echo "usage: $0 path/to/eps2img [runs]"
+	exit 2
+fi
+
+program=$(cd "$(dirname "$1")" && pwd)/$(basename "$1")
+runs=${2:-7}
+output=bench-output.pdf
+
+cd "$(dirname "$0")" || exit 2
+
+sh make-hex.sh 10 > hex-literal.ps
+
+for op in def load get put; do
+	sh make-dict.sh $op 10 > dict-$op-10.ps
+	sh make-dict.sh $op 1000 > dict-$op-1k.ps
+	sh make-dict.sh $op 100000 > dict-$op-100k.ps
+done
+
+for file in *.ps; do
+	best=
+
+	for i in $(seq "$runs"); do
+		start=$(date +%s%N)
+		"$program" "$file" $output > /dev/null 2>&1
+		end=$(date +%s%N)
+		time=$(( (end - start) / 1000 ))
+
+		if [ -z "$best" ] || [ $time -lt $best ]; then
+			best=$time
+		fi
+	done
+
+	printf '%-20s %d.%03d ms\n' "$file" $((best / 1000)) $((best % 1000))
+done
+
+for file in ../samples/tiger.ps ../samples/dore.ps; do
+	best=
+
+	for i in $(seq "$runs"); do
+		# Scanned <tokens> tokens in <time> us
+		set -- $("$program" -scan "$file" $output 2>/dev/null | grep '^Scanned')
+		tokens=$2
+		time=$5
+
+		if [ -z "$best" ] || [ $time -lt $best ]; then
+			best=$time
+		fi
+	done
+
+	[ $best -gt 0 ] || best=1
+
+	printf '%-20s %d tokens/s\n' "$(basename "$file") (scan)" $((tokens * 1000000 / best))
+done
+
+rm -f $output hex-literal.ps dict-*.ps
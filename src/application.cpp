@@ -11,10 +11,12 @@
 */
 
 #include "application.h"
+#include <chrono>
 
 bool application::run_loop(scanner& sc, double width, double height, bool is_interactive)
 {
 	bool result = true;
+	bool recording = m_use_cache && !is_interactive;
 	processor proc(sc);
 	token tkn;
 
@@ -31,6 +33,10 @@ bool application::run_loop(scanner& sc, double width, double height, bool is_int
 
 		if (sc.get_token(tkn, error))
 		{
+			if (recording)
+			{
+				m_cache.record(tkn);
+			}
 			if (!proc.process_token(tkn))
 			{
 				if (proc.has_error())
@@ -60,11 +66,7 @@ bool application::run_loop(scanner& sc, double width, double height, bool is_int
 				}
 			}
 		}
-		else if (sc.is_eof()) // normal exit
-		{
-			break;
-		}
-		else if (sc.has_error())
+		else if (sc.has_error()) // checked first; an unterminated string also ends the input
 		{
 			int column, row;
 
@@ -76,11 +78,23 @@ bool application::run_loop(scanner& sc, double width, double height, bool is_int
 			{
 				m_error.clear();
 
+				sc.set_error(false);
+
 				continue;
 			}
 			result = false;
 			break;
 		}
+		else if (sc.needs_input()) // push mode
+		{
+			feed_input(sc);
+
+			continue;
+		}
+		else if (sc.is_eof()) // normal exit
+		{
+			break;
+		}
 	}
 
 	//cout << "\nDumping...\n";
@@ -89,9 +103,164 @@ bool application::run_loop(scanner& sc, double width, double height, bool is_int
 
 	proc.save_file(m_output_file.c_str());
 
+	if (m_show_stats)
+	{
+		print_stats(proc);
+	}
+
+	// a program that reads its own input (currentfile token) can't be replayed
+	if (result && recording && !sc.read_directly())
+	{
+		if (!m_cache.save())
+		{
+			cout << m_cache.error() << endl;
+		}
+	}
+
 	return result;
 }
 
+bool application::replay_loop(scanner& sc, double width, double height)
+{
+	bool result = true;
+	processor proc(sc);
+	token tkn;
+
+	if (!proc.init_graphics(width, height))
+	{
+		m_error = "Unable to initialize the graphics output";
+
+		return false;
+	}
+
+	try
+	{
+		while (m_cache.next(tkn))
+		{
+			if (!proc.process_token(tkn))
+			{
+				if (proc.has_error())
+				{
+					m_error = proc.error();
+
+					result = false;
+				}
+				break;
+			}
+		}
+	}
+	catch (const exception& ex)
+	{
+		m_error = ex.what();
+
+		result = false;
+	}
+
+	proc.save_file(m_output_file.c_str());
+
+	if (m_show_stats)
+	{
+		print_stats(proc);
+	}
+
+	return result;
+}
+
+// -scan: the input is tokenized without being run, to time the scanner alone
+
+bool application::scan_loop(scanner& sc)
+{
+	token tkn;
+	size_t count = 0;
+	auto start = chrono::steady_clock::now();
+
+	while (true)
+	{
+		bool error = false;
+
+		if (sc.get_token(tkn, error))
+		{
+			++count;
+		}
+		else if (sc.has_error())
+		{
+			int column, row;
+
+			sc.get_error(column, row, m_error);
+
+			return false;
+		}
+		else if (sc.is_eof())
+		{
+			break;
+		}
+	}
+
+	auto elapsed = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start);
+
+	cout << "Scanned " << count << " tokens in " << elapsed.count() << " us\n";
+
+	return true;
+}
+
+// push mode (-feed): the input is handed to the scanner as the tokens need it, in
+// chunks of m_feed_size bytes, as a caller that receives the data in pieces would
+
+bool application::feed_file(scanner& sc, const char* filename)
+{
+	bool result;
+
+	m_feed_file = (strcmp(filename, "-") == 0) ? stdin : fopen(filename, "rb");
+
+	if (!m_feed_file)
+	{
+		m_error = "Unable to open file: ";
+
+		m_error.append(filename);
+
+		return false;
+	}
+
+	sc.feed(nullptr, 0);
+
+	result = run_loop(sc, DEFAULT_WIDTH, DEFAULT_HEIGHT, false);
+
+	if (m_feed_file != stdin)
+	{
+		fclose(m_feed_file);
+	}
+
+	m_feed_file = nullptr;
+
+	return result;
+}
+
+void application::feed_input(scanner& sc)
+{
+	vector<char> chunk(m_feed_size);
+	size_t len = fread(chunk.data(), 1, chunk.size(), m_feed_file);
+
+	if (len > 0)
+	{
+		sc.feed(chunk.data(), len);
+	}
+	else
+	{
+		sc.end_input();
+	}
+}
+
+void application::print_stats(const processor& proc)
+{
+	const name_cache_stats& names = proc.name_cache();
+	const pool_stats& objects = proc.object_stats();
+
+	cout << "\nName cache: " << names.m_hits << " hits, " << names.m_misses << " misses\n";
+	cout << "Objects: " << objects.m_allocations << " allocated, " << objects.m_frees << " freed, "
+		<< objects.m_live << " live, " << objects.m_hits << " reused, " << objects.m_large << " large, "
+		<< objects.m_permanent << " permanent, " << objects.m_slabs << " slabs\n";
+}
+
 bool application::create_output_filename(const char* filename, const char* output_file)
 {
 	if (output_file)
@@ -113,7 +282,7 @@ bool application::create_output_filename(const char* filename, const char* outpu
 	{
 		size_t pos;
 
-		if (filename)
+		if (filename && strcmp(filename, "-") != 0)
 		{
 			m_output_file = filename;
 
@@ -152,8 +321,29 @@ bool application::convert(const char* filename, const char *output_file)
 	{
 		return run_loop(sc, width, height, true);
 	}
+	else if (m_feed_size > 0)
+	{
+		return feed_file(sc, filename);
+	}
 	else
 	{
+		if (m_use_cache && !m_scan_only)
+		{
+			// streams can't be hashed in advance
+			if (!m_cache.open(filename))
+			{
+				m_use_cache = false;
+			}
+			else if (m_cache.load())
+			{
+				sc.load_dsc(m_cache.dsc());
+
+				return replay_loop(sc, DEFAULT_WIDTH, DEFAULT_HEIGHT);
+			}
+		}
+
+		sc.map_files(m_map_files);
+
 		if (!sc.load_file(filename, width, height))
 		{
 			m_error = sc.error();
@@ -170,6 +360,11 @@ bool application::convert(const char* filename, const char *output_file)
 			height = DEFAULT_HEIGHT;
 		}
 
+		if (m_scan_only)
+		{
+			return scan_loop(sc);
+		}
+
 		return run_loop(sc, DEFAULT_WIDTH, DEFAULT_HEIGHT, false);
 	}
 }
@@ -14,16 +14,29 @@
 #pragma once
 #include "scanner.h"
 #include "processor.h"
+#include "token-cache.h"
 
 
 class application
 {
 	string m_error;
 	string m_output_file;
+	bool m_use_cache{ false };
+	bool m_map_files{ true };
+	bool m_show_stats{ false };
+	bool m_scan_only{ false };
+	size_t m_feed_size{ 0 }; // nonzero: the input is pushed to the scanner in chunks of this size
+	FILE* m_feed_file{ nullptr };
+	token_cache m_cache;
 	bool run_loop(scanner &sc, double width, double height, bool is_interactive);
+	bool replay_loop(scanner& sc, double width, double height);
+	bool scan_loop(scanner& sc);
 	bool create_output_filename(const char* filename, const char* output_file);
+	void print_stats(const processor& proc);
+	void feed_input(scanner& sc);
+	bool feed_file(scanner& sc, const char* filename);
 public:
-	application() : m_error(), m_output_file()
+	application() : m_error(), m_output_file(), m_cache()
 	{
 	}
 	~application()
@@ -37,5 +50,25 @@ public:
 	{
 		return m_output_file;
 	}
+	void use_token_cache(bool value)
+	{
+		m_use_cache = value;
+	}
+	void map_files(bool value)
+	{
+		m_map_files = value;
+	}
+	void show_stats(bool value)
+	{
+		m_show_stats = value;
+	}
+	void feed_in_chunks(size_t size)
+	{
+		m_feed_size = size;
+	}
+	void scan_only(bool value)
+	{
+		m_scan_only = value;
+	}
 	bool convert(const char* filename, const char* output_file);
 };
\ No newline at end of file
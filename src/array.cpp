@@ -13,7 +13,7 @@
 
 #include "processor.h"
 
-void processor::do_array(operator_handler* handler)
+void processor::do_array(const operator_handler* handler)
 {
 	operand& op1 = m_operand_stack[0];
 	
@@ -51,7 +51,7 @@ void processor::do_array(operator_handler* handler)
 	}
 }
 
-void processor::do_astore(operator_handler* handler)
+void processor::do_astore(const operator_handler* handler)
 {
 	operand& op1 = m_operand_stack[0];
 
@@ -80,18 +80,16 @@ void processor::do_astore(operator_handler* handler)
 				{
 					message("Stack underflow in --%s--", handler->m_name);
 				}
+				operand array = pop_operand();
+
 				for (size_t i = 0, index = array_size - 1; i < array_size; ++i, --index)
 				{
-					// exchange position
-					do_exch();
-
-					//put the top item on the array
+					arr->put(index, std::move(m_operand_stack[i]));
+				}
 
-					arr->put(index, m_operand_stack[0]);
+				pop(array_size);
 
-					// remove the top item
-					pop();
-				}
+				push_operand(std::move(array));
 			}
 		}
 		else
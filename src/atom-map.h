@@ -0,0 +1,226 @@
+/*
+//  Copyright (c) 2020 Peter Frane Jr. All Rights Reserved.
+//
+//  Use of this source code is governed by the GPL v. 3.0 license that can be
+//  found in the LICENSE file.
+//
+//  This software is distributed on an "AS IS" basis, WITHOUT WARRANTY
+//  OF ANY KIND, either express or implied.
+//
+//  For inquiries, email the author at pfranejr AT hotmail.com
+*/
+
+#pragma once
+#include "name-table.h"
+#include <vector>
+
+#define NO_ATOM 0xFFFFFFFF
+#define ATOM_MAP_MIN_SIZE 8
+
+// Open-addressing hash table keyed on atoms, for the dictionaries. The slots are
+// one array, a power of two in size and at most 3/4 full, probed linearly.
+// Entries are never removed one at a time, so no tombstones are needed.
+// Adding an entry may move the others
+
+template<typename T>
+class atom_map
+{
+public:
+	struct entry
+	{
+		atom first{ NO_ATOM };
+		T second;
+	};
+	template<typename E>
+	class basic_iterator
+	{
+		E* m_slot;
+		E* m_end;
+		void skip_empty()
+		{
+			while (m_slot != m_end && NO_ATOM == m_slot->first)
+			{
+				++m_slot;
+			}
+		}
+	public:
+		basic_iterator(E* slot, E* end) : m_slot(slot), m_end(end)
+		{
+			skip_empty();
+		}
+		E& operator*() const
+		{
+			return *m_slot;
+		}
+		E* operator->() const
+		{
+			return m_slot;
+		}
+		basic_iterator& operator++()
+		{
+			++m_slot;
+			skip_empty();
+
+			return *this;
+		}
+		bool operator!=(const basic_iterator& other) const
+		{
+			return m_slot != other.m_slot;
+		}
+	};
+	using iterator = basic_iterator<entry>;
+	using const_iterator = basic_iterator<const entry>;
+private:
+	vector<entry> m_slots;
+	size_t m_size{ 0 };
+	uint32_t m_shift{ 32 }; // 32 - log2(slot count)
+
+	size_t slot_of(atom name) const
+	{
+		// Fibonacci hashing: atoms are small consecutive integers
+		return (size_t)((name * 2654435769u) >> m_shift);
+	}
+	void rehash(size_t slot_count)
+	{
+		vector<entry> old;
+		uint32_t shift = 32;
+
+		for (size_t n = slot_count; n > 1; n >>= 1)
+		{
+			--shift;
+		}
+
+		old.swap(m_slots);
+
+		m_slots.resize(slot_count);
+		m_shift = shift;
+
+		for (entry& e : old)
+		{
+			if (e.first != NO_ATOM)
+			{
+				size_t mask = m_slots.size() - 1;
+				size_t i = slot_of(e.first);
+
+				while (m_slots[i].first != NO_ATOM)
+				{
+					i = (i + 1) & mask;
+				}
+
+				m_slots[i].first = e.first;
+				m_slots[i].second = std::move(e.second);
+			}
+		}
+	}
+public:
+	atom_map() : m_slots()
+	{
+	}
+	explicit atom_map(size_t count) : m_slots()
+	{
+		reserve(count);
+	}
+	size_t size() const
+	{
+		return m_size;
+	}
+	bool empty() const
+	{
+		return 0 == m_size;
+	}
+	// room for 'count' entries without rehashing
+	void reserve(size_t count)
+	{
+		size_t slot_count = ATOM_MAP_MIN_SIZE;
+
+		while (slot_count * 3 < count * 4)
+		{
+			slot_count <<= 1;
+		}
+		if (slot_count > m_slots.size())
+		{
+			rehash(slot_count);
+		}
+	}
+	void clear()
+	{
+		for (entry& e : m_slots)
+		{
+			if (e.first != NO_ATOM)
+			{
+				e.first = NO_ATOM;
+				e.second = T();
+			}
+		}
+
+		m_size = 0;
+	}
+	T* find(atom name)
+	{
+		if (m_size > 0)
+		{
+			size_t mask = m_slots.size() - 1;
+
+			for (size_t i = slot_of(name); ; i = (i + 1) & mask)
+			{
+				entry& e = m_slots[i];
+
+				if (name == e.first)
+				{
+					return &e.second;
+				}
+				else if (NO_ATOM == e.first)
+				{
+					return nullptr;
+				}
+			}
+		}
+		return nullptr;
+	}
+	// the value of 'name', added if missing; only adding may rehash
+	T& operator[](atom name)
+	{
+		T* value = find(name);
+		size_t mask;
+		size_t i;
+
+		if (value)
+		{
+			return *value;
+		}
+		if ((m_size + 1) * 4 > m_slots.size() * 3)
+		{
+			rehash(m_slots.empty() ? ATOM_MAP_MIN_SIZE : m_slots.size() * 2);
+		}
+
+		mask = m_slots.size() - 1;
+		i = slot_of(name);
+
+		while (m_slots[i].first != NO_ATOM)
+		{
+			i = (i + 1) & mask;
+		}
+
+		m_slots[i].first = name;
+
+		++m_size;
+
+		return m_slots[i].second;
+	}
+	iterator begin()
+	{
+		return iterator(m_slots.data(), m_slots.data() + m_slots.size());
+	}
+	iterator end()
+	{
+		return iterator(m_slots.data() + m_slots.size(), m_slots.data() + m_slots.size());
+	}
+	const_iterator begin() const
+	{
+		return const_iterator(m_slots.data(), m_slots.data() + m_slots.size());
+	}
+	const_iterator end() const
+	{
+		return const_iterator(m_slots.data() + m_slots.size(), m_slots.data() + m_slots.size());
+	}
+};
@@ -12,6 +12,7 @@
 
 
 #include "data.h"
+#include <cmath>
 
 operand::operand() : m_dummy(0)
 {
@@ -22,6 +23,16 @@ operand::operand(const operand& op) : m_dummy(0)
 	copy(op);
 }
 
+// takes over the reference of 'op'
+operand::operand(operand&& op) noexcept : m_dummy(op.m_dummy)
+{
+	m_exec = op.m_exec;
+	m_type = op.m_type;
+
+	op.m_type = ot_null;
+	op.m_dummy = 0;
+}
+
 operand::operand(operand_type type) : m_dummy(0)
 {
 	m_type = type;
@@ -33,6 +44,12 @@ operand::operand(double value, bool is_real)
 	m_type = is_real ? ot_real : ot_integer;
 }
 
+operand::operand(atom name, operand_type type) : m_dummy(0)
+{
+	m_atom = name;
+	m_type = type;
+}
+
 operand::~operand()
 {
 	clear();
@@ -60,6 +77,28 @@ operand& operand::operator=(const operand& op)
 	return *this;
 }
 
+operand& operand::operator=(operand&& op) noexcept
+{
+	if (this != &op)
+	{
+		// released last, in case 'op' belongs to it
+		composite_object* old = (m_type > ot_composite) ? m_object : nullptr;
+
+		m_dummy = op.m_dummy;
+		m_exec = op.m_exec;
+		m_type = op.m_type;
+
+		op.m_type = ot_null;
+		op.m_dummy = 0;
+
+		if (old)
+		{
+			old->release();
+		}
+	}
+	return *this;
+}
+
 void operand::copy(const operand& op)
 {
 	m_type = op.m_type;
@@ -68,12 +107,9 @@ void operand::copy(const operand& op)
 	{
 		if (op.m_object)
 		{
-			m_object = dynamic_cast<composite_object*>(op.m_object);
+			m_object = op.m_object;
 
-			if (m_object)
-			{
-				m_object->addref();
-			}
+			m_object->addref();
 		}
 		else
 		{
@@ -185,9 +221,9 @@ bool operand::is_matrix() const
 {
 	if (ot_array == m_type && m_object != nullptr)
 	{
-		array_type* arr = dynamic_cast<array_type*>(m_object);
+		array_type* arr = object_cast<array_type>(m_object);
 
-		if (arr && arr->is_matrix())
+		if (arr->is_matrix())
 		{
 			return true;
 		}
@@ -200,9 +236,9 @@ bool operand::is_matrix(double* values)
 {
 	if (ot_array == m_type && m_object != nullptr)
 	{
-		array_type* arr = dynamic_cast<array_type*>(m_object);
+		array_type* arr = object_cast<array_type>(m_object);
 
-		if (arr && arr->is_matrix())
+		if (arr->is_matrix())
 		{
 			arr->get_numbers(values, 6);
 
@@ -238,7 +274,7 @@ array_type* operand::as_array()
 	{
 		if (m_object)
 		{
-			return dynamic_cast<array_type*>(m_object);
+			return object_cast<array_type>(m_object);
 		}
 	}
 	return nullptr;
@@ -250,7 +286,7 @@ base_dictionary* operand::as_dictionary()
 	{
 		if (m_object)
 		{
-			return dynamic_cast<base_dictionary*>(m_object);
+			return object_cast<base_dictionary>(m_object);
 		}
 	}
 	return nullptr;
@@ -258,16 +294,50 @@ base_dictionary* operand::as_dictionary()
 
 string_type* operand::as_string()
 {
-	if (is_string_type())
+	if (is_text_string())
 	{
 		if (m_object)
 		{
-			return dynamic_cast<string_type*>(m_object);
+			return object_cast<string_type>(m_object);
 		}
 	}
 	return nullptr;
 }
 
+// the characters of a string, name or literal
+
+string_view operand::string_value() const
+{
+	if (ot_name == m_type || ot_literal == m_type)
+	{
+		return atom_name(m_atom);
+	}
+	else if (is_text_string() && m_object)
+	{
+		return static_cast<const string_type*>(m_object)->m_data;
+	}
+	return string_view();
+}
+
+// names and strings are interchangeable as dictionary keys
+
+bool operand::key_atom(atom& name) const
+{
+	if (ot_name == m_type || ot_literal == m_type)
+	{
+		name = m_atom;
+
+		return true;
+	}
+	else if (is_text_string() && m_object)
+	{
+		name = intern(static_cast<const string_type*>(m_object)->m_data);
+
+		return true;
+	}
+	return false;
+}
+
 void operand::clone(const operand& src, alloc_type atype)
 {
 	clear();
@@ -282,7 +352,7 @@ void operand::clone(const operand& src, alloc_type atype)
 			
 			if (src.is_array_type())
 			{
-				array_type* arr = dynamic_cast<array_type*>(obj);
+				array_type* arr = object_cast<array_type>(obj);
 
 				if (arr)
 				{
@@ -296,13 +366,13 @@ void operand::clone(const operand& src, alloc_type atype)
 			}
 			else if (src.is_dictionary())
 			{
-				base_dictionary* base = dynamic_cast<base_dictionary*>(obj);
+				base_dictionary* base = object_cast<base_dictionary>(obj);
 
 				if (base )
 				{
 					if (base->subtype() == ot_user_dictionary)
 					{
-						dictionary_type* dict = dynamic_cast<dictionary_type*>(base);
+						dictionary_type* dict = object_cast<dictionary_type>(base);
 
 						if (dict)
 						{
@@ -417,10 +487,14 @@ ostream& operator<<(ostream& os, const operand& op)
 	case ot_save:
 		os << "-save-";
 		break;
-	case ot_hex_string:
 	case ot_literal:
-	case ot_text_string:
+		os << '/' << atom_name(op.m_atom);
+		break;
 	case ot_name:
+		os << atom_name(op.m_atom);
+		break;
+	case ot_hex_string:
+	case ot_text_string:
 		if (op.m_object)
 		{
 			((string_type*)op.m_object)->write(os);
@@ -434,74 +508,98 @@ ostream& operator<<(ostream& os, const operand& op)
 	return os;
 }
 
-void dictionary_type::insert(dictionary& dict, string& key, const operand& value)
+bool value_key::make(const operand& op, value_key& key)
 {
-	try
+	switch (op.m_type)
 	{
-		auto it = dict.find(key);
-
-		if (it == dict.end())
+	case ot_boolean:
+		key.m_type = ot_boolean;
+		key.m_bits = op.m_bool ? 1 : 0;
+		return true;
+	case ot_integer:
+		key.m_type = ot_integer;
+		key.m_bits = (uint64_t)(int64_t)op.m_number;
+		return true;
+	case ot_real:
+		if (op.m_number == floor(op.m_number) && fabs(op.m_number) <= INT32_MAX)
 		{
-			dict[key] = value;
+			key.m_type = ot_integer;
+			key.m_bits = (uint64_t)(int64_t)op.m_number;
 		}
-		else // replace
+		else
 		{
-			it->second = value;
+			key.m_type = ot_real;
+			memcpy(&key.m_bits, &op.m_number, sizeof(key.m_bits));
 		}
+		return true;
 	}
-	catch (...)
+	return false;
+}
+
+operand value_key::to_operand() const
+{
+	operand op(m_type);
+
+	switch (m_type)
 	{
-		throw;
+	case ot_boolean:
+		op.m_bool = (m_bits != 0);
+		break;
+	case ot_integer:
+		op.m_number = (double)(int64_t)m_bits;
+		break;
+	case ot_real:
+		memcpy(&op.m_number, &m_bits, sizeof(op.m_number));
+		break;
 	}
+	return op;
 }
 
-void dictionary_type::insert(const operand& key, const operand& value)
+uint32_t base_dictionary::m_epoch = 1;
+
+void dictionary_type::insert(const operand& key, operand&& value)
 {
+	atom name;
+
 	switch (key.m_type)
 	{
 	case ot_hex_string:
 	case ot_literal:
+	case ot_name:
 	case ot_text_string:
-		if( key.m_object)
+		if (key.key_atom(name))
 		{
-			string_type* str = dynamic_cast<string_type*>(key.m_object);
+			size_t count = m_data.size();
 
-			if (str)
+			m_data[name] = std::move(value);
+
+			// a replaced value is seen through the cached pointer to it; a new
+			// name may hide another definition, and may move the other entries
+			if (m_data.size() != count)
 			{
-				insert(m_data, str->m_data, value);
+				changed();
 			}
 		}
 		break;
 	default:
 		{
-		string str;
+			value_key vkey;
 
-			switch (key.m_type)
+			if (value_key::make(key, vkey))
 			{
-			case ot_boolean:
-			case ot_integer:
-			case ot_real:
-				to_string(str, key);
-				insert(m_data2, str, value);
-				break;
+				m_data2[vkey] = std::move(value);
 			}
 		}
 		break;
 	}
 }
 
-operand* dictionary_type::find(const char* name)
+operand* dictionary_type::find(atom name)
 {
-	auto it = m_data.find(string(name));
-
-	if (it != m_data.end())
-	{
-		return &(it->second);
-	}
-	return nullptr;
+	return m_data.find(name);
 }
 
-bool dictionary_type::key_exists(const char* name)
+bool dictionary_type::key_exists(atom name)
 {
 	return find(name) != nullptr;
 }
@@ -511,26 +609,6 @@ bool dictionary_type::key_exists(const operand& key)
 	return find(key) != nullptr;
 }
 
-void dictionary_type::to_string(string& str, const operand& key)
-{
-	char buf[32]{ 0 };
-
-	switch (key.m_type)
-	{
-	case ot_boolean:
-		str = (key.m_bool) ? "true" : "false";
-		break;
-	case ot_integer:
-		sprintf_s(buf, sizeof(buf) - 1, "%d", (int32_t)key.m_number);
-		str = buf;
-		break;
-	case ot_real:
-		sprintf_s(buf, sizeof(buf) - 1, "%f", (float)key.m_number);
-		str = buf;
-		break;
-	}
-}
-
 operand* dictionary_type::find(const operand& key)
 {
 	switch (key.m_type)
@@ -539,11 +617,11 @@ operand* dictionary_type::find(const operand& key)
 	case ot_integer:
 	case ot_real:
 		{
-			string str;
+			value_key vkey;
 
-			to_string(str, key);
+			value_key::make(key, vkey);
 
-			auto it = m_data2.find(str);
+			auto it = m_data2.find(vkey);
 
 			if (it != m_data2.end())
 			{
@@ -553,28 +631,23 @@ operand* dictionary_type::find(const operand& key)
 		break;
 	case ot_hex_string:
 	case ot_literal:
+	case ot_name:
 	case ot_text_string:
-		if (key.m_object)
 		{
-			string_type* str = dynamic_cast<string_type*>(key.m_object);
+			atom name;
 
-			if (str)
+			if (key.key_atom(name))
 			{
-				auto it = m_data.find(str->m_data);
-
-				if (it != m_data.end())
-				{
-					return &(it->second);
-				}
+				return find(name);
 			}
-		}		
+		}
 		break;
 	}
 
 	return nullptr;
 }
 
-bool dictionary_type::find(const char* name, operand& value)
+bool dictionary_type::find(atom name, operand& value)
 {
 	operand* result = find(name);
 
@@ -614,7 +687,7 @@ void dictionary_type::clone()
 
 dictionary_type* dictionary_type::clone(alloc_type atype)
 {
-	dictionary_type* dict = new dictionary_type(atype);
+	dictionary_type* dict = new dictionary_type(m_data.size(), atype);
 
 	if (!dict)
 	{
@@ -698,6 +771,49 @@ array_type* array_type::clone(alloc_type atype)
 	}
 }
 
+void array_type::compile()
+{
+	m_code.resize(m_data.size());
+
+	for (size_t i = 0; i < m_data.size(); ++i)
+	{
+		operand& item = m_data[i];
+		instruction& code = m_code[i];
+
+		code.m_epoch = 0;
+
+		if (item.is_name())
+		{
+			code.m_type = it_name;
+			code.m_atom = item.m_atom;
+		}
+		else if (item.is_operator())
+		{
+			code.m_type = it_operator;
+			code.m_operator = item.m_operator;
+		}
+		else if (ot_array_marker_off == item.m_type)
+		{
+			code.m_type = it_array;
+		}
+		else if (ot_dictionary_marker_off == item.m_type)
+		{
+			code.m_type = it_dictionary;
+		}
+		else if (ot_procedure_marker_off == item.m_type)
+		{
+			code.m_type = it_nop;
+		}
+		else
+		{
+			code.m_type = it_push;
+			code.m_operand = &item;
+		}
+	}
+
+	m_compiled = true;
+}
+
 void string_type::write(ostream& os)
 {
 	if (ot_text_string == m_type)
@@ -738,26 +854,18 @@ void string_type::write(ostream& os)
 		}
 		os << ')';
 	}
-	else if (ot_literal == m_type)
-	{
-		os << '/' << m_data;
-	}
-	else if (ot_name == m_type)
-	{
-		os << m_data;
-	}
 }
 
 void dictionary_type::write(ostream& os)
 {
 	for (auto& v : m_data)
 	{
-		cout << v.first << " -> ";
+		cout << atom_name(v.first) << " -> ";
 		cout << v.second << '\n';
 	}
 	for (auto& v : m_data2)
 	{
-		cout << v.first << " -> ";
+		cout << v.first.to_operand() << " -> ";
 		cout << v.second << '\n';
 	}
 }
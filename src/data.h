@@ -12,16 +12,22 @@
 
 #pragma once
 #include <string>
+#include <string_view>
 #include <iterator>
 #include <iostream>
 #include <iomanip>
 
 #include <map>
+#include <unordered_map>
 #include <deque>
+#include <vector>
 #include <forward_list>
 #include <inttypes.h>
 #include <stdarg.h>
 #include "operator_id.h"
+#include "name-table.h"
+#include "atom-map.h"
+#include "object-pool.h"
 
 #pragma warning(disable : 4996)
 #pragma warning(disable : 26812)
@@ -40,7 +46,7 @@ using namespace std;
 
 
 //enum class operand_type
-enum operand_type
+enum operand_type : uint8_t
 {
 	ot_null,	
 	ot_array_marker_on,
@@ -57,6 +63,8 @@ enum operand_type
 	ot_procedure_marker_on,
 	ot_procedure_marker_off,
 	ot_real,
+	ot_literal, // m_atom
+	ot_name, // m_atom
 	ot_composite,
 	ot_ascii_text_b85,
 	ot_array,
@@ -66,8 +74,6 @@ enum operand_type
 	ot_system_dictionary,
 	ot_font,
 	ot_hex_string,
-	ot_literal,
-	ot_name,
 	ot_procedure,
 	ot_save,
 	
@@ -83,6 +89,7 @@ enum alloc_type
 class composite_object
 {
 	int m_refcount{ 1 };
+	bool m_permanent{ false }; // in the arena of the job; not reference counted
 protected:
 	operand_type m_type;// { operand_type::ot_null };
 	alloc_type m_alloc_type{ at_local };
@@ -93,13 +100,30 @@ public:
 	virtual ~composite_object()
 	{
 	}
+	// from the object pool of the current processor
+	static void* operator new(size_t size)
+	{
+		return object_pool::allocate(size);
+	}
+	static void operator delete(void* ptr)
+	{
+		object_pool::deallocate(ptr);
+	}
 	int addref()
 	{
+		if (m_permanent)
+		{
+			return m_refcount;
+		}
 		return ++m_refcount;
 	}
 	int release()
 	{
-		if (0 == --m_refcount)
+		if (m_permanent)
+		{
+			return m_refcount;
+		}
+		else if (0 == --m_refcount)
 		{
 			delete this;
 
@@ -112,12 +136,42 @@ public:
 	{
 		return m_alloc_type;
 	}
+	void set_permanent()
+	{
+		m_permanent = true;
+	}
+	// for the objects still alive when their pool is destroyed (see
+	// object_pool::set_teardown); a detached object is no longer counted
+	static void detach(void* ptr)
+	{
+		((composite_object*)ptr)->m_permanent = true;
+	}
+	static void destroy(void* ptr)
+	{
+		((composite_object*)ptr)->~composite_object();
+	}
 	virtual void write(ostream& os) = 0;
 	virtual int32_t size() const = 0;
 	virtual void clear() = 0;
 
 };
 
+// Downcast of the object of a composite operand. The class follows from the
+// operand type (array_type for arrays and procedures, base_dictionary for
+// dictionaries, and so on), so the cast needs no RTTI. Debug builds check it
+
+template<typename T>
+inline T* object_cast(composite_object* obj)
+{
+#ifdef _DEBUG
+	if (obj && dynamic_cast<T*>(obj) != obj)
+	{
+		throw runtime_error("Object does not match the operand type");
+	}
+#endif
+	return static_cast<T*>(obj);
+}
+
 struct operator_handler;
 class processor;
 struct array_type;
@@ -135,18 +189,22 @@ struct operand
 		double m_number;
 		scanner* m_scanner;
 		composite_object* m_object;
-		operator_handler* m_operator;
+		const operator_handler* m_operator;
+		atom m_atom;
 		uint64_t m_dummy;
 	};
+	operand_type m_type{ ot_null }; // one byte, next to the payload
 	bool m_exec{ false };
-	operand_type m_type{ ot_null };
 	operand();
 	operand(const operand& op);
+	operand(operand&& op) noexcept;
 	operand(operand_type type);
 	operand(double value, bool is_real);
+	operand(atom name, operand_type type);
 	~operand();
 	void clear();
 	operand& operator=(const operand& op);	
+	operand& operator=(operand&& op) noexcept;
 	void copy(const operand& op);
 	bool is_array() const;
 	bool is_array_type() const;
@@ -174,22 +232,58 @@ struct operand
 	array_type* as_array();
 	base_dictionary* as_dictionary();
 	string_type* as_string();
+	string_view string_value() const;
+	bool key_atom(atom& name) const;
 	void clone(const operand& src, alloc_type atype);
 	
 	friend ostream& operator<<(ostream &os, const operand& op);
 };
 
+// the payload and the type fit in two words, so arrays of operands are dense
+static_assert(sizeof(operand_type) == 1, "operand_type must fit in a byte");
+static_assert(sizeof(operand) == 16, "operand must be 16 bytes");
+static_assert(alignof(operand) == 8, "operand must be 8-byte aligned");
+
+// compiled form of a procedure body: one instruction per item, with the
+// type tests done once instead of on every execution
+
+enum instruction_type : uint8_t
+{
+	it_push,
+	it_name,
+	it_operator,
+	it_array,
+	it_dictionary,
+	it_nop
+};
+
+struct instruction
+{
+	instruction_type m_type;
+	atom m_atom; // it_name
+	uint32_t m_epoch; // it_name: dictionary epoch of the cached lookup; 0 if none
+	union
+	{
+		operand* m_operand; // it_push
+		const operator_handler* m_operator; // it_operator, or it_name resolved to an operator
+	};
+	operand* m_value; // it_name resolved to a dictionary entry
+};
+
 struct array_type : public composite_object
 {
-	deque<operand> m_data;
-	array_type() : composite_object(ot_array, at_local), m_data()
+	vector<operand> m_data; // contiguous; m_code holds pointers into it, rebuilt when it changes
+	vector<instruction> m_code;
+	bool m_compiled{ false }; // m_code matches m_data
+	int m_running{ 0 }; // executions in progress; m_code is not rebuilt while nonzero
+	array_type() : composite_object(ot_array, at_local), m_data(), m_code()
 	{
 	}
-	array_type(size_t size, operand_type type) : composite_object(type, at_local), m_data()
+	array_type(size_t size, operand_type type) : composite_object(type, at_local), m_data(), m_code()
 	{
 		m_data.resize(size);
 	}
-	array_type(size_t size, operand_type type, alloc_type _alloc_type) : composite_object(type, _alloc_type), m_data()
+	array_type(size_t size, operand_type type, alloc_type _alloc_type) : composite_object(type, _alloc_type), m_data(), m_code()
 	{
 		m_data.resize(size);
 	}
@@ -209,11 +303,16 @@ struct array_type : public composite_object
 		}
 		throw runtime_error("Range check in --get--");
 	}
-	void put(size_t index, operand &op)
+	void put(size_t index, const operand &op)
+	{
+		put(index, operand(op));
+	}
+	void put(size_t index, operand&& op)
 	{
 		if (index < m_data.size())
 		{
-			m_data[index] = op;
+			m_data[index] = std::move(op);
+			m_compiled = false;
 		}
 		else
 		{
@@ -223,16 +322,19 @@ struct array_type : public composite_object
 	void put(operand& op)
 	{
 		m_data.push_back( op );
+		m_compiled = false;
 	}
 	array_type& operator=(const array_type& src)
 	{
 		m_data = src.m_data;
+		m_compiled = false;
 
 		return *this;
 	}
 	void clear()
 	{
 		m_data.clear();
+		m_compiled = false;
 	}
 	bool is_numeric()
 	{
@@ -277,6 +379,7 @@ struct array_type : public composite_object
 	}
 	void write(ostream& os);
 	array_type* clone(alloc_type atype);
+	void compile();
 };
 
 struct string_type : public composite_object
@@ -351,6 +454,18 @@ struct string_type : public composite_object
 
 struct base_dictionary : public composite_object
 {
+	// bumped whenever a name may resolve to something else: a name is added,
+	// a dictionary is cleared, pushed or popped, or a state is restored. The
+	// name lookups cached in compiled procedures are valid for one epoch
+	static uint32_t m_epoch;
+
+	static void changed()
+	{
+		if (0 == ++m_epoch)
+		{
+			m_epoch = 1;
+		}
+	}
 	base_dictionary() : composite_object(ot_dictionary, at_local)
 	{
 	}
@@ -364,22 +479,49 @@ struct base_dictionary : public composite_object
 	virtual int32_t size() const = 0;
 	virtual void write(ostream& os) = 0;
 	
-	virtual bool find(const char* name, operand& value) = 0;
+	virtual bool find(atom name, operand& value) = 0;
 	virtual bool find(const operand& key, operand& value) = 0;
-	virtual bool key_exists(const char* name) = 0;
+	virtual bool key_exists(atom name) = 0;
 	virtual bool key_exists(const operand& key) = 0;
-	virtual void put(const operand& key, const operand& value) = 0;
+	// 'value' points to the entry, or is null if the entry can't be referenced
+	virtual bool lookup(atom name, operand*& value) = 0;
+	virtual void put(const operand& key, operand value) = 0; // moved in
 	virtual void clone() = 0;
 	virtual bool get(const operand& key, operand& value) = 0;
 	virtual operand_type subtype() const = 0;
 };
 
-using dictionary = map<string, operand>;
+// a numeric or boolean dictionary key. Reals with an integral value are stored
+// as integers, so 1 and 1.0 are the same key, as they are equal under eq
+
+struct value_key
+{
+	operand_type m_type{ ot_null };
+	uint64_t m_bits{ 0 }; // the integer, the bits of the real, or the boolean
+
+	bool operator==(const value_key& key) const
+	{
+		return m_type == key.m_type && m_bits == key.m_bits;
+	}
+	static bool make(const operand& op, value_key& key);
+	operand to_operand() const;
+};
+
+struct value_key_hash
+{
+	size_t operator()(const value_key& key) const
+	{
+		return (size_t)((key.m_bits ^ ((uint64_t)key.m_type << 56)) * 0x9E3779B97F4A7C15ULL >> 16);
+	}
+};
+
+using value_dictionary = unordered_map<value_key, operand, value_key_hash>;
+using name_dictionary = atom_map<operand>;
 
 struct dictionary_type : public base_dictionary
 {
-	dictionary m_data;
-	dictionary m_data2; // for non-string keys
+	name_dictionary m_data; // names, and strings converted to names
+	value_dictionary m_data2; // for numeric and boolean keys
 
 	size_t m_max_size{ 65536 };
 
@@ -389,7 +531,7 @@ struct dictionary_type : public base_dictionary
 	dictionary_type(alloc_type _alloc_type) : base_dictionary(_alloc_type), m_data(), m_data2()
 	{
 	}
-	dictionary_type(size_t max_size, alloc_type _alloc_type) : base_dictionary(_alloc_type), m_data(), m_data2(), m_max_size(max_size)
+	dictionary_type(size_t max_size, alloc_type _alloc_type) : base_dictionary(_alloc_type), m_data(max_size), m_data2(), m_max_size(max_size)
 	{
 	}	
 	~dictionary_type()
@@ -404,9 +546,11 @@ struct dictionary_type : public base_dictionary
 	{
 		m_data.clear();
 		m_data2.clear();
+
+		changed();
 	}
 	
-	bool find(const char* name, operand &value);
+	bool find(atom name, operand &value);
 	bool find(const operand& key, operand& value);
 	void clone();
 	dictionary_type* clone(alloc_type atype);
@@ -422,24 +566,30 @@ struct dictionary_type : public base_dictionary
 
 		m_data2 = dct.m_data2;
 
+		changed();
+
 		return *this;
 	}
-	void put(const operand& key, const operand& value)
+	void put(const operand& key, operand value)
 	{
-		insert(key, value);
+		insert(key, std::move(value));
 	}
 	operand_type subtype() const
 	{
 		return ot_user_dictionary;
 	}
-	bool key_exists(const char* name);
+	bool key_exists(atom name);
 	bool key_exists(const operand& key);
+	bool lookup(atom name, operand*& value)
+	{
+		value = find(name);
+
+		return value != nullptr;
+	}
 protected:
-	void insert(dictionary& dict, string& key, const operand& value);
-	void to_string(string& str, const operand& key);		
-	operand *find(const char* name);
+	operand *find(atom name);
 	operand* find(const operand& key);
-	void insert(const operand& key, const operand& value);
+	void insert(const operand& key, operand&& value);
 };
 
 
@@ -499,7 +649,7 @@ struct dictionary_container : public composite_object
 		{
 			if (it->subtype() == ot_user_dictionary)
 			{
-				dictionary_type* dict = dynamic_cast<dictionary_type*>(it);
+				dictionary_type* dict = object_cast<dictionary_type>(it);
 
 				if (dict)// can't be null
 				{
@@ -555,9 +705,9 @@ struct dictionary_container : public composite_object
 
 		return op;
 	}
-	void put(const operand& key, const operand& value)
+	void put(const operand& key, operand value)
 	{
-		m_current_dictionary->put(key, value);
+		m_current_dictionary->put(key, std::move(value));
 	}
 	base_dictionary* where(const operand& key)
 	{
@@ -576,7 +726,7 @@ struct dictionary_container : public composite_object
 
 		return nullptr;
 	}
-	bool find(const char* name, operand& value)
+	bool find(atom name, operand& value)
 	{
 		for (auto it : m_dictionary_stack)
 		{
@@ -591,6 +741,17 @@ struct dictionary_container : public composite_object
 		}
 		return false;
 	}
+	bool lookup(atom name, operand*& value)
+	{
+		for (auto it : m_dictionary_stack)
+		{
+			if (it->lookup(name, value))
+			{
+				return true;
+			}
+		}
+		return m_local_dictionary.lookup(name, value);
+	}
 	bool find(const operand &key, operand& value)
 	{
 		for (auto it : m_dictionary_stack)
@@ -614,6 +775,8 @@ struct dictionary_container : public composite_object
 		dict->addref();
 
 		m_current_dictionary = dict;
+
+		base_dictionary::changed();
 	}
 	bool pop()
 	{
@@ -627,6 +790,8 @@ struct dictionary_container : public composite_object
 
 			m_current_dictionary = get_current_dictionary();
 
+			base_dictionary::changed();
+
 			return true;
 		}
 
@@ -692,7 +857,7 @@ struct operator_handler
 	size_t m_param_count;
 	bool m_numeric_param;
 	operator_id m_op_id;
-	void (processor::* func)(operator_handler* handler);
+	void (processor::* func)(const operator_handler* handler);
 };
 
 enum slant_type
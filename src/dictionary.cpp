@@ -14,7 +14,7 @@
 
 static int counter = 0;
 
-void processor::do_name(const char* name, operand_type type)
+void processor::do_name(atom name, operand_type type)
 {
 	operand value;
 
@@ -22,7 +22,7 @@ void processor::do_name(const char* name, operand_type type)
 	{
 		if (in_procedure())
 		{
-			push_name(name, -1, type);
+			push_name(name, type);
 
 			return;
 		}
@@ -59,56 +59,169 @@ void processor::do_name(const char* name, operand_type type)
 		}
 		else
 		{
-			message("Undefined in --%s--", name);
+			string_view str = atom_name(name);
+
+			message("Undefined in --%.*s--", (int)str.size(), str.data());
 		}		
 	}
 }
 
+// keeps a procedure alive, and its compiled code unchanged, while it runs
+
+struct running_procedure
+{
+	array_type* m_proc;
+	running_procedure(array_type* proc) : m_proc(proc)
+	{
+		m_proc->addref();
+		++m_proc->m_running;
+	}
+	~running_procedure()
+	{
+		--m_proc->m_running;
+		m_proc->release();
+	}
+};
+
+void processor::execute_item(operand& item)
+{
+	if (item.is_name())
+	{
+		do_name(item.m_atom, item.m_type);
+	}
+	else if (item.is_operator())
+	{
+		execute_operator(item.m_operator);
+	}
+	else if (item.is_marker_off())
+	{
+		if (ot_array_marker_off == item.m_type)
+		{
+			create_array(ot_array);
+		}
+		else if (ot_dictionary_marker_off == item.m_type)
+		{
+			create_dictionary();
+		}
+	}
+	else
+	{
+		push_operand(item);
+	}
+}
+
+// a name in a compiled procedure: the result of the dictionary lookup is kept
+// in the instruction until the dictionary epoch changes
+
+void processor::execute_name(instruction& code)
+{
+	if (in_procedure())
+	{
+		do_name(code.m_atom, ot_name);
+
+		return;
+	}
+	if (code.m_epoch != base_dictionary::m_epoch)
+	{
+		operand* value = nullptr;
+
+		++m_name_cache.m_misses;
+
+		if (m_dictionary->lookup(code.m_atom, value) && value)
+		{
+			code.m_value = value;
+		}
+		else
+		{
+			operand op;
+
+			// not defined, or found in systemdict
+			if (!search_system_dictionary(code.m_atom, op) || !op.is_operator())
+			{
+				do_name(code.m_atom, ot_name);
+
+				return;
+			}
+
+			code.m_value = nullptr;
+			code.m_operator = op.m_operator;
+		}
+
+		code.m_epoch = base_dictionary::m_epoch;
+	}
+	else
+	{
+		++m_name_cache.m_hits;
+	}
+
+	if (!code.m_value)
+	{
+		execute_operator(code.m_operator);
+	}
+	else if (code.m_value->is_procedure())
+	{
+		execute_procedure(*code.m_value);
+	}
+	else if (code.m_value->is_operator())
+	{
+		execute_operator(code.m_value->m_operator);
+	}
+	else
+	{
+		push_operand(*code.m_value);
+	}
+}
+
 void processor::execute_procedure(operand &op)
 {	
+	array_type* proc = op.as_array();
+
+	if (proc)
 	{
-		array_type* proc = op.as_array();
+		running_procedure running(proc);
+		size_t i = 0;
+
+		if (!proc->m_compiled && 1 == proc->m_running)
+		{
+			proc->compile();
+		}
 
-		if (proc)
+		// the code is compiled on the first call, and again after the body changes
+		// (put, bind); if it changes while running, the rest is executed item by item
+
+		for (; i < proc->m_code.size() && proc->m_compiled; ++i)
 		{
-			for (operand& item : proc->m_data)
+			const instruction& code = proc->m_code[i];
+
+			switch (code.m_type)
 			{
-				if (item.is_name())
-				{
-					if (item.m_object)
-					{
-						string_type* str = dynamic_cast<string_type*>(item.m_object);
-						if (str)
-						{
-							do_name(str->data(), item.m_type);
-						}
-					}
-				}
-				else if (item.is_operator())
-				{
-					execute_operator(item.m_operator);
-				}
-				else if (item.is_marker_off())
-				{
-					if (ot_array_marker_off == item.m_type)
-					{
-						create_array(ot_array);
-					}
-					else if (ot_dictionary_marker_off == item.m_type)
-					{
-						create_dictionary();
-					}
-				}
-				else
-				{
-					push_operand(item);
-				}
+			case it_push:
+				push_operand(*code.m_operand);
+				break;
+			case it_name:
+				execute_name(proc->m_code[i]);
+				break;
+			case it_operator:
+				execute_operator(code.m_operator);
+				break;
+			case it_array:
+				create_array(ot_array);
+				break;
+			case it_dictionary:
+				create_dictionary();
+				break;
+			case it_nop:
+				break;
 			}
 		}
+		for (; i < proc->m_data.size(); ++i)
+		{
+			execute_item(proc->m_data[i]);
+		}
 	}
 }
 
-void processor::execute_operator(operator_handler* handler)
+void processor::execute_operator(const operator_handler* handler)
 {
 	size_t param_count = handler->m_param_count;
 	size_t stack_size = m_operand_stack.size();
@@ -149,7 +262,7 @@ void processor::create_dictionary()
 	}
 	else
 	{
-		dictionary_type* dct = new dictionary_type((size_t)index, m_alloc_type);
+		dictionary_type* dct = new dictionary_type((size_t)index / 2, m_alloc_type);
 
 		if (!dct)
 		{
@@ -166,18 +279,18 @@ void processor::create_dictionary()
 				operand& value = m_operand_stack[start_index];
 				operand& key = m_operand_stack[start_index + 1];
 
-				dct->put(key, value);
+				dct->put(key, std::move(value));
 			}
 			// remove the items and marker from the stack
 
 			pop(index + 1);
 
-			push_operand(op);
+			push_operand(std::move(op));
 		}
 	}
 }
 
-void processor::do_def(operator_handler* handler)
+void processor::do_def(const operator_handler* handler)
 {
 	operand& value = m_operand_stack[0];
 	operand& key = m_operand_stack[1];
@@ -211,7 +324,7 @@ void processor::do_dictionary_end()
 	}
 }
 
-void processor::do_dictionary_ops(operator_handler* handler)
+void processor::do_dictionary_ops(const operator_handler* handler)
 {
 	switch (handler->m_op_id)
 	{
@@ -249,19 +362,13 @@ void processor::do_bind(operand &op)
 		{
 			if (it.is_name())
 			{
-				string_type* str = dynamic_cast<string_type*>(it.m_object);
+				operand value;
 
-				if (str)
+				if (search_system_dictionary(it.m_atom, value))
 				{
-					const char* name = str->data();
-					operand value;
-					
-					if(search_system_dictionary(name, value))
-					{						
-						// replace
-
-						it = value;
-					}
+					// replace
+
+					it = value;
 				}
 			}
 			else if (it.is_procedure())
@@ -269,6 +376,8 @@ void processor::do_bind(operand &op)
 				do_bind(it);
 			}
 		}
+
+		arr->m_compiled = false;
 	}
 	else if (!op.is_procedure())
 	{
@@ -326,10 +435,9 @@ void processor::do_load(operand& key)
 	}
 	else if (key.is_string_type())
 	{
-		const string_type* str = key.as_string();
-		operand value;
+		string_view name = key.string_value();
 
-		if (search_system_dictionary(str->data(), value))
+		if (find_key(key, value))
 		{
 			pop();
 
@@ -337,7 +445,7 @@ void processor::do_load(operand& key)
 		}
 		else
 		{
-			message("Undefined in --load-- (key '%s' not found)", str->data());
+			message("Undefined in --load-- (key '%.*s' not found)", (int)name.size(), name.data());
 		}
 
 	}
@@ -347,13 +455,11 @@ void processor::do_load(operand& key)
 	}
 }
 
-void processor::do_where(operator_handler* handler)
+void processor::do_where(const operator_handler* handler)
 {
 	operand result(ot_boolean);
-	operand key = m_operand_stack[0];
+	operand key = pop_operand();
 	base_dictionary *dict;
-
-	pop();
 	
 	dict = m_dictionary->where(key);
 
@@ -369,41 +475,30 @@ void processor::do_where(operator_handler* handler)
 	}
 	else if (key.is_string_type())
 	{
-		string_type* str = key.as_string();
+		operand value;
 
-		if (str)
+		if (find_key(key, value))
 		{
-			const char* name = str->data();
-			operand value;
+			system_dictionary* sys_dict = new system_dictionary(this);
 
-			if (search_system_dictionary(name, value))
+			if (sys_dict)
 			{
-				system_dictionary* sys_dict = new system_dictionary(this);
+				operand dict_op(ot_dictionary);
 
-				if (sys_dict)
-				{
-					operand dict_op(ot_dictionary);
-
-					dict_op.m_object = sys_dict;
+				dict_op.m_object = sys_dict;
 
-					push_operand(dict_op);
-				}
-				else
-				{
-					message("Not enough memory to create a dictionary object");
-				}
-
-				result.m_bool = true;
+				push_operand(dict_op);
 			}
 			else
 			{
-				result.m_bool = false;
+				message("Not enough memory to create a dictionary object");
 			}
+
+			result.m_bool = true;
 		}
 		else
 		{
-			// not possible since key name can't be null
-			message("Type check in --where--");
+			result.m_bool = false;
 		}
 	}
 	else
@@ -411,10 +506,10 @@ void processor::do_where(operator_handler* handler)
 		result.m_bool = false;		
 	}
 
-	push_operand(result);
+	push_operand(std::move(result));
 }
 
-void processor::do_repeat(operator_handler* handler)
+void processor::do_repeat(const operator_handler* handler)
 {
 	operand& op1 = m_operand_stack[0];
 	operand& op2 = m_operand_stack[1];
@@ -433,7 +528,7 @@ void processor::do_repeat(operator_handler* handler)
 		}
 		else
 		{
-			operand proc = op1;
+			operand proc = std::move(op1);
 
 			pop(2);
 
@@ -449,7 +544,7 @@ void processor::do_repeat(operator_handler* handler)
 	}
 }
 
-void processor::do_for(operator_handler* handler)
+void processor::do_for(const operator_handler* handler)
 {
 	operand& op4 = m_operand_stack[0];
 	operand& op3 = m_operand_stack[1];
@@ -463,7 +558,7 @@ void processor::do_for(operator_handler* handler)
 		double initial = op1.m_number;
 		double increment = op2.m_number;
 		double limit = op3.m_number;
-		operand proc = op4;
+		operand proc;
 		
 		{
 			if (0.0 == increment)
@@ -476,6 +571,8 @@ void processor::do_for(operator_handler* handler)
 				operand_type new_type = initial_type == increment_type ? initial_type : ot_real;
 				int32_t loop_count = ++m_loop_count;
 
+				proc = std::move(op4);
+
 				pop(handler->m_param_count);
 
 				if (increment > 0.0)
@@ -511,7 +608,7 @@ void processor::do_for(operator_handler* handler)
 
 static int get_count = 0;
 
-void processor::do_get(operator_handler* handler)
+void processor::do_get(const operator_handler* handler)
 {
 	operand& op1 = m_operand_stack[0];
 	operand& op2 = m_operand_stack[1];
@@ -584,7 +681,7 @@ void processor::do_get(operator_handler* handler)
 	}
 }
 
-void processor::do_put(operator_handler* handler)
+void processor::do_put(const operator_handler* handler)
 {
 	operand& op1 = m_operand_stack[0];
 	operand& op2 = m_operand_stack[1];
@@ -626,7 +723,7 @@ void processor::do_put(operator_handler* handler)
 	}
 }
 
-void processor::do_length(operator_handler* handler)
+void processor::do_length(const operator_handler* handler)
 {
 	operand& op = m_operand_stack[0];
 
@@ -649,6 +746,14 @@ void processor::do_length(operator_handler* handler)
 			pop();
 		}
 	}
+	else if (op.is_literal() || op.is_name())
+	{
+		size_t len = op.string_value().size();
+
+		pop();
+
+		push_number((double)len, ot_integer);
+	}
 	else
 	{
 		message("Type check in --length--");
@@ -656,7 +761,7 @@ void processor::do_length(operator_handler* handler)
 }
 
 
-void processor::do_save(operator_handler* handler)
+void processor::do_save(const operator_handler* handler)
 {
 	dictionary_container* cur_dict = new dictionary_container;
 
@@ -687,13 +792,13 @@ void processor::do_save(operator_handler* handler)
 	}
 }
 
-void processor::do_restore(operator_handler* handler)
+void processor::do_restore(const operator_handler* handler)
 {
 	operand& op = m_operand_stack[0];
 
 	if (op.is_save())
 	{
-		dictionary_container* old_dct = dynamic_cast<dictionary_container *>(op.m_object);
+		dictionary_container* old_dct = object_cast<dictionary_container>(op.m_object);
 
 		if (old_dct)
 		{
@@ -702,6 +807,8 @@ void processor::do_restore(operator_handler* handler)
 			m_dictionary = old_dct;
 
 			m_dictionary->addref(); // addref; old_dct will be destroyed below
+
+			base_dictionary::changed();
 			
 			pop();
 
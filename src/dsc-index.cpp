@@ -0,0 +1,236 @@
+/*
+//  Copyright (c) 2020 Peter Frane Jr. All Rights Reserved.
+//
+//  Use of this source code is governed by the GPL v. 3.0 license that can be
+//  found in the LICENSE file.
+//
+//  This software is distributed on an "AS IS" basis, WITHOUT WARRANTY
+//  OF ANY KIND, either express or implied.
+//
+//  For inquiries, email the author at pfranejr AT hotmail.com
+*/
+
+#include "dsc-index.h"
+#include <cstring>
+
+// true if 'line' starts with 'keyword'; 'rest' is set to what follows it
+static bool match_keyword(const char* line, size_t len, const char* keyword, const char*& rest, size_t& rest_len)
+{
+	size_t keyword_len = strlen(keyword);
+
+	if (len < keyword_len || memcmp(line, keyword, keyword_len) != 0)
+	{
+		return false;
+	}
+
+	rest = line + keyword_len;
+	rest_len = len - keyword_len;
+
+	return true;
+}
+
+void dsc_index::clear()
+{
+	*this = dsc_index();
+}
+
+void dsc_index::read_bounding_box(const char* values, size_t len, double* box, bool& found, bool& atend)
+{
+	char buf[MAX_LINE_BUF + 1];
+	double x1, y1, x2, y2;
+
+	// the first valid one in the header wins, unless it is '(atend)'
+	if (found && !(atend && !m_in_header))
+	{
+		return;
+	}
+
+	if (len > MAX_LINE_BUF)
+	{
+		len = MAX_LINE_BUF;
+	}
+	memcpy(buf, values, len);
+
+	buf[len] = 0;
+
+	if (sscanf_s(buf, "%lf %lf %lf %lf", &x1, &y1, &x2, &y2) == 4)
+	{
+		box[0] = x1;
+		box[1] = y1;
+		box[2] = x2;
+		box[3] = y2;
+
+		found = true;
+		atend = false;
+	}
+	else if (m_in_header && strstr(buf, "(atend)"))
+	{
+		atend = true;
+	}
+}
+
+void dsc_index::add_line(const char* line, size_t len, size_t offset, size_t next)
+{
+	const char* rest;
+	size_t rest_len;
+
+	if (len < 3 || line[0] != '%' || line[1] != '%')
+	{
+		// the header ends at the first line that is not a comment
+		if (m_in_header && (0 == len || line[0] != '%'))
+		{
+			m_in_header = false;
+		}
+		return;
+	}
+
+	line += 2;
+	len -= 2;
+
+	if (match_keyword(line, len, "BeginDocument", rest, rest_len))
+	{
+		++m_document_depth;
+	}
+	else if (match_keyword(line, len, "EndDocument", rest, rest_len))
+	{
+		if (m_document_depth > 0)
+		{
+			--m_document_depth;
+		}
+	}
+	else if (m_document_depth > 0)
+	{
+		return;
+	}
+	else if (match_keyword(line, len, "BoundingBox:", rest, rest_len))
+	{
+		read_bounding_box(rest, rest_len, m_bounding_box, m_has_bounding_box, m_bounding_box_atend);
+	}
+	else if (match_keyword(line, len, "HiResBoundingBox:", rest, rest_len))
+	{
+		read_bounding_box(rest, rest_len, m_hires_bounding_box, m_has_hires_bounding_box, m_hires_bounding_box_atend);
+	}
+	else if (match_keyword(line, len, "EndComments", rest, rest_len))
+	{
+		m_in_header = false;
+	}
+	else if (match_keyword(line, len, "Page:", rest, rest_len))
+	{
+		dsc_page page;
+		size_t end = rest_len;
+
+		m_in_header = false;
+
+		// %%Page: label ordinal
+		while (end > 0 && isspace((uint8_t)rest[end - 1]))
+		{
+			--end;
+		}
+		size_t start = end;
+
+		while (start > 0 && !isspace((uint8_t)rest[start - 1]))
+		{
+			--start;
+		}
+
+		page.m_ordinal = atoi(string(rest + start, end - start).c_str());
+
+		while (start > 0 && isspace((uint8_t)rest[start - 1]))
+		{
+			--start;
+		}
+		size_t label = 0;
+
+		while (label < start && isspace((uint8_t)rest[label]))
+		{
+			++label;
+		}
+
+		page.m_label.assign(rest + label, start - label);
+		page.m_offset = offset;
+
+		m_pages.push_back(page);
+	}
+	else if (match_keyword(line, len, "BeginProlog", rest, rest_len))
+	{
+		m_in_header = false;
+		m_prolog.m_begin = offset;
+	}
+	else if (match_keyword(line, len, "EndProlog", rest, rest_len))
+	{
+		m_prolog.m_end = next;
+	}
+	else if (match_keyword(line, len, "BeginSetup", rest, rest_len))
+	{
+		m_in_header = false;
+		m_setup.m_begin = offset;
+	}
+	else if (match_keyword(line, len, "EndSetup", rest, rest_len))
+	{
+		m_setup.m_end = next;
+	}
+	else if (match_keyword(line, len, "Trailer", rest, rest_len))
+	{
+		m_in_header = false;
+		m_trailer = offset;
+	}
+}
+
+static const char* find_char(const char* p, const char* end, char ch)
+{
+	const char* found = (const char*)memchr(p, ch, end - p);
+
+	return found ? found : end;
+}
+
+void dsc_index::build(const char* data, size_t size)
+{
+	const char* p = data;
+	const char* end = data + size;
+	// the next '\n' and '\r'; each is searched for again only once passed, so the
+	// input is scanned once for each whatever the line endings
+	const char* lf = find_char(p, end, '\n');
+	const char* cr = find_char(p, end, '\r');
+
+	clear();
+
+	while (p < end)
+	{
+		const char* eol;
+		const char* next;
+
+		if (lf < p)
+		{
+			lf = find_char(p, end, '\n');
+		}
+		if (cr < p)
+		{
+			cr = find_char(p, end, '\r');
+		}
+
+		eol = (lf < cr) ? lf : cr;
+
+		// only lines that start with '%' are examined; skip the rest quickly
+		if (*p != '%' && !m_in_header)
+		{
+			p = (eol < end) ? eol + 1 : end;
+
+			continue;
+		}
+
+		next = eol;
+
+		if (next < end && '\r' == *next)
+		{
+			++next;
+		}
+		if (next < end && '\n' == *next)
+		{
+			++next;
+		}
+
+		add_line(p, eol - p, p - data, next - data);
+
+		p = next;
+	}
+}
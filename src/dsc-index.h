@@ -0,0 +1,76 @@
+/*
+//  Copyright (c) 2020 Peter Frane Jr. All Rights Reserved.
+//
+//  Use of this source code is governed by the GPL v. 3.0 license that can be
+//  found in the LICENSE file.
+//
+//  This software is distributed on an "AS IS" basis, WITHOUT WARRANTY
+//  OF ANY KIND, either express or implied.
+//
+//  For inquiries, email the author at pfranejr AT hotmail.com
+*/
+
+#pragma once
+#include "data.h"
+#include <vector>
+
+#define DSC_NO_OFFSET SIZE_MAX
+
+// byte range of a DSC section, from the start of its Begin line to the end of its End line
+struct dsc_range
+{
+	size_t m_begin{ DSC_NO_OFFSET };
+	size_t m_end{ DSC_NO_OFFSET };
+	bool is_valid() const
+	{
+		return m_begin != DSC_NO_OFFSET && m_end != DSC_NO_OFFSET;
+	}
+};
+
+struct dsc_page
+{
+	string m_label;
+	int32_t m_ordinal{ 0 };
+	size_t m_offset{ 0 }; // start of the %%Page: line
+};
+
+// Document structure of the input, collected in one pass before execution.
+// Comments of embedded documents (%%BeginDocument ... %%EndDocument) are ignored
+
+struct dsc_index
+{
+	bool m_has_bounding_box{ false };
+	bool m_has_hires_bounding_box{ false };
+	double m_bounding_box[4]{ 0 };
+	double m_hires_bounding_box[4]{ 0 };
+	vector<dsc_page> m_pages;
+	dsc_range m_prolog;
+	dsc_range m_setup;
+	size_t m_trailer{ DSC_NO_OFFSET };
+private:
+	bool m_in_header{ true };
+	bool m_bounding_box_atend{ false };
+	bool m_hires_bounding_box_atend{ false };
+	int m_document_depth{ 0 };
+	void read_bounding_box(const char* values, size_t len, double* box, bool& found, bool& atend);
+public:
+	dsc_index() : m_pages()
+	{
+	}
+	~dsc_index()
+	{
+	}
+	void clear();
+	// 'offset' is the position of 'line' in the input; 'next' is the position of the following line
+	void add_line(const char* line, size_t len, size_t offset, size_t next);
+	// the whole input is in memory
+	void build(const char* data, size_t size);
+	double width() const
+	{
+		return m_bounding_box[2] - m_bounding_box[0];
+	}
+	double height() const
+	{
+		return m_bounding_box[3] - m_bounding_box[1];
+	}
+};
@@ -18,10 +18,58 @@ int main(int argc, char* argv[])
 	cout << "EPS2IMG (c) 2020 Peter Frane Jr. All Rights Reserved\n";
 	cout << "Distributed under a GPL 3.0 license\n\n";
 
+	bool use_cache = false;
+	bool map_files = true;
+	bool show_stats = false;
+	bool scan_only = false;
+	size_t feed_size = 0;
+
+	// options come first; "-" alone is the standard input
+	while (argc > 1 && '-' == argv[1][0] && argv[1][1])
+	{
+		if (strcmp(argv[1], "-cache") == 0)
+		{
+			use_cache = true;
+		}
+		else if (strcmp(argv[1], "-nomap") == 0)
+		{
+			map_files = false;
+		}
+		else if (strcmp(argv[1], "-stats") == 0)
+		{
+			show_stats = true;
+		}
+		else if (strcmp(argv[1], "-scan") == 0)
+		{
+			scan_only = true;
+		}
+		else if (strcmp(argv[1], "-feed") == 0 && argc > 2)
+		{
+			feed_size = (size_t)atoi(argv[2]);
+
+			--argc;
+			++argv;
+		}
+		else
+		{
+			break;
+		}
+
+		--argc;
+		++argv;
+	}
+
 	if (argc < 2)
 	{
-		cout << "\nUsage: eps2img input_file [output_file.pdf]\n";
-		cout << "\n       Where 'input_file' is an EPS file regardless of file extension (i.e., .EPS or .PS).\n\n";
+		cout << "\nUsage: eps2img [-cache] [-nomap] [-stats] [-scan] [-feed size] input_file [output_file.pdf]\n";
+		cout << "\n       Where 'input_file' is an EPS file regardless of file extension (i.e., .EPS or .PS),\n";
+		cout << "       or '-' to read it from the standard input.\n";
+		cout << "\n       -cache saves the tokens of 'input_file' to 'input_file.tkc' and reuses them\n";
+		cout << "       on later runs while the input is unchanged.\n";
+		cout << "\n       -nomap reads 'input_file' line by line instead of mapping it into memory.\n";
+		cout << "\n       -stats prints the name cache and object allocation counts at the end.\n";
+		cout << "\n       -scan only tokenizes the input and prints the token count and scanning time.\n";
+		cout << "\n       -feed hands the input to the interpreter in chunks of 'size' bytes (push mode).\n\n";
 
 		return 1;
 	}
@@ -30,6 +78,12 @@ int main(int argc, char* argv[])
 		const char* output_file = argc > 2 ? argv[2] : nullptr;
 		application app;
 
+		app.use_token_cache(use_cache);
+		app.map_files(map_files);
+		app.show_stats(show_stats);
+		app.feed_in_chunks(feed_size);
+		app.scan_only(scan_only);
+
 		if (app.convert(argv[1], output_file))
 		{
 			cout << "\nSuccess (" << app.output_file() << ")\n";
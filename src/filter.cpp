@@ -0,0 +1,412 @@
+/*
+//  Copyright (c) 2020 Peter Frane Jr. All Rights Reserved.
+//
+//  Use of this source code is governed by the GPL v. 3.0 license that can be
+//  found in the LICENSE file.
+//
+//  This software is distributed on an "AS IS" basis, WITHOUT WARRANTY
+//  OF ANY KIND, either express or implied.
+//
+//  For inquiries, email the author at pfranejr AT hotmail.com
+*/
+
+#include "filter.h"
+
+// output is staged in blocks of this size on the stack
+static constexpr size_t BULK_SIZE = 4096;
+
+static inline bool is_ascii85_digit(uint8_t ch)
+{
+	return ch >= '!' && ch <= 'u';
+}
+
+static inline bool is_space(uint8_t ch)
+{
+	return ' ' == ch || '\n' == ch || '\r' == ch || '\t' == ch || '\f' == ch || 0 == ch;
+}
+
+static inline uint64_t ascii85_group(const uint8_t* p)
+{
+	return (((((uint64_t)(p[0] - '!') * 85 + (p[1] - '!')) * 85 + (p[2] - '!')) * 85 + (p[3] - '!')) * 85) + (p[4] - '!');
+}
+
+#ifdef HAS_SSE2
+// true if all 16 bytes are in '!'..'u'
+static inline bool are_ascii85_digits(const uint8_t* p)
+{
+	const __m128i v = _mm_loadu_si128((const __m128i*)p);
+	const __m128i bad = _mm_or_si128(_mm_cmplt_epi8(v, _mm_set1_epi8('!')), _mm_cmpgt_epi8(v, _mm_set1_epi8('u')));
+
+	return 0 == _mm_movemask_epi8(bad);
+}
+#endif
+
+// nibble values of hex digits; 0xFF for everything else
+
+struct hex_table
+{
+	uint8_t m_value[256];
+};
+
+static constexpr hex_table make_hex_table()
+{
+	hex_table table{};
+
+	for (int ch = 0; ch < 256; ++ch)
+	{
+		table.m_value[ch] = 0xFF;
+	}
+	for (int ch = '0'; ch <= '9'; ++ch)
+	{
+		table.m_value[ch] = (uint8_t)(ch - '0');
+	}
+	for (int ch = 'a'; ch <= 'f'; ++ch)
+	{
+		table.m_value[ch] = (uint8_t)(ch - 'a' + 10);
+		table.m_value[ch - 'a' + 'A'] = (uint8_t)(ch - 'a' + 10);
+	}
+
+	return table;
+}
+
+static constexpr hex_table hex_values = make_hex_table();
+
+#ifdef HAS_SSE2
+// decodes 16 hex digits into 8 bytes; false if any of them is not a hex digit
+static inline bool decode_hex_block(const uint8_t* p, char* dst)
+{
+	const __m128i v = _mm_loadu_si128((const __m128i*)p);
+	const __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+	const __m128i is_digit = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8('9' + 1)));
+	const __m128i is_alpha = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(lower, _mm_set1_epi8('f' + 1)));
+
+	if (_mm_movemask_epi8(_mm_or_si128(is_digit, is_alpha)) != 0xFFFF)
+	{
+		return false;
+	}
+
+	const __m128i nibbles = _mm_or_si128(_mm_and_si128(is_digit, _mm_sub_epi8(v, _mm_set1_epi8('0'))),
+		_mm_and_si128(is_alpha, _mm_sub_epi8(lower, _mm_set1_epi8('a' - 10))));
+	// each 16-bit lane holds (high nibble, low nibble) in memory order
+	const __m128i bytes = _mm_or_si128(_mm_and_si128(_mm_slli_epi16(nibbles, 4), _mm_set1_epi16(0x00FF)), _mm_srli_epi16(nibbles, 8));
+
+	_mm_storel_epi64((__m128i*)dst, _mm_packus_epi16(bytes, bytes));
+
+	return true;
+}
+#endif
+
+void ascii85_decoder::put_group(char* dst, uint64_t value)
+{
+	if (value > 0xFFFFFFFF)
+	{
+		message("Invalid ASCII85 group: value is out of range");
+	}
+
+	dst[0] = (char)(value >> 24);
+	dst[1] = (char)(value >> 16);
+	dst[2] = (char)(value >> 8);
+	dst[3] = (char)value;
+}
+
+size_t ascii85_decoder::decode(const char* src, size_t len, string& out)
+{
+	const uint8_t* p = (const uint8_t*)src;
+	const uint8_t* end = p + len;
+
+	while (p < end && !m_eod)
+	{
+		// whole groups in bulk while no group is pending
+		while (0 == m_count && end - p >= 5)
+		{
+			const uint8_t* limit = p + min<size_t>(end - p, BULK_SIZE / 4 * 5);
+			char buf[BULK_SIZE];
+			char* dst = buf;
+#ifdef HAS_SSE2
+			// three groups per 16 validated bytes
+			while (limit - p >= 16 && are_ascii85_digits(p))
+			{
+				put_group(dst, ascii85_group(p));
+				put_group(dst + 4, ascii85_group(p + 5));
+				put_group(dst + 8, ascii85_group(p + 10));
+
+				p += 15;
+				dst += 12;
+			}
+#endif
+			while (limit - p >= 5 && is_ascii85_digit(p[0]) && is_ascii85_digit(p[1]) && is_ascii85_digit(p[2])
+				&& is_ascii85_digit(p[3]) && is_ascii85_digit(p[4]))
+			{
+				put_group(dst, ascii85_group(p));
+
+				p += 5;
+				dst += 4;
+			}
+
+			out.append(buf, dst - buf);
+
+			if (limit - p >= 5)
+			{
+				break;
+			}
+		}
+		if (p >= end)
+		{
+			break;
+		}
+
+		// group split by whitespace or buffer end, 'z', or the EOD marker
+		uint8_t ch = *p++;
+
+		if (is_ascii85_digit(ch))
+		{
+			m_tuple = m_tuple * 85 + (ch - '!');
+
+			if (5 == ++m_count)
+			{
+				char buf[4];
+
+				put_group(buf, m_tuple);
+
+				out.append(buf, 4);
+
+				m_tuple = 0;
+				m_count = 0;
+			}
+		}
+		else if ('z' == ch)
+		{
+			if (m_count != 0)
+			{
+				message("Invalid ASCII85 string: 'z' inside a group");
+			}
+			out.append(4, 0);
+		}
+		else if ('~' == ch)
+		{
+			m_eod = true;
+		}
+		else if (!is_space(ch))
+		{
+			message("Invalid character in ASCII85 string: %d", ch);
+		}
+	}
+
+	return (const char*)p - src;
+}
+
+void ascii85_decoder::finish(string& out)
+{
+	if (1 == m_count)
+	{
+		message("Invalid ASCII85 string: final group has only one character");
+	}
+	else if (m_count > 1)
+	{
+		char buf[4];
+		int count = m_count;
+
+		// pad with 'u'; only count - 1 bytes are significant
+		while (m_count < 5)
+		{
+			m_tuple = m_tuple * 85 + ('u' - '!');
+
+			++m_count;
+		}
+
+		put_group(buf, m_tuple);
+
+		out.append(buf, count - 1);
+	}
+
+	m_tuple = 0;
+	m_count = 0;
+}
+
+string_view decode_filter::read_source()
+{
+	if (m_source)
+	{
+		return m_source->read_raw();
+	}
+	return m_unread;
+}
+
+void decode_filter::skip_source(size_t len)
+{
+	if (m_source)
+	{
+		m_source->skip_raw(len);
+	}
+	else
+	{
+		m_unread.remove_prefix(len);
+	}
+}
+
+bool ascii85_filter::read(string& out)
+{
+	string_view src;
+	size_t len;
+
+	if (m_eof)
+	{
+		return false;
+	}
+
+	src = read_source();
+
+	if (src.empty())
+	{
+		// the source ended without '~>'
+		m_decoder.finish(out);
+
+		m_eof = true;
+
+		return !out.empty();
+	}
+
+	len = m_decoder.decode(src.data(), src.size(), out);
+
+	skip_source(len);
+
+	if (m_decoder.eod())
+	{
+		src = read_source();
+
+		if (src.empty() || src[0] != '>')
+		{
+			message("Invalid ASCII85 string: '~' must be followed by '>'");
+		}
+
+		skip_source(1);
+
+		m_decoder.finish(out);
+
+		m_eof = true;
+	}
+
+	return true;
+}
+
+size_t hex_decoder::decode(const char* src, size_t len, string& out)
+{
+	const uint8_t* p = (const uint8_t*)src;
+	const uint8_t* end = p + len;
+
+	while (p < end && !m_eod)
+	{
+		// whole pairs in bulk while no digit is pending
+		while (m_pending < 0 && end - p >= 2)
+		{
+			const uint8_t* limit = p + min<size_t>(end - p, BULK_SIZE * 2);
+			char buf[BULK_SIZE];
+			char* dst = buf;
+#ifdef HAS_SSE2
+			while (limit - p >= 16 && decode_hex_block(p, dst))
+			{
+				p += 16;
+				dst += 8;
+			}
+#endif
+			while (limit - p >= 2 && (hex_values.m_value[p[0]] | hex_values.m_value[p[1]]) < 16)
+			{
+				*dst++ = (char)((hex_values.m_value[p[0]] << 4) | hex_values.m_value[p[1]]);
+
+				p += 2;
+			}
+
+			out.append(buf, dst - buf);
+
+			if (limit - p >= 2)
+			{
+				break;
+			}
+		}
+		if (p >= end)
+		{
+			break;
+		}
+
+		// pair split by whitespace or buffer end, or the EOD marker
+		uint8_t ch = *p++;
+		uint8_t value = hex_values.m_value[ch];
+
+		if (value < 16)
+		{
+			if (m_pending < 0)
+			{
+				m_pending = value;
+			}
+			else
+			{
+				out.push_back((char)((m_pending << 4) | value));
+
+				m_pending = -1;
+			}
+		}
+		else if ('>' == ch)
+		{
+			m_eod = true;
+		}
+		else if (is_space(ch))
+		{
+			while (p < end && is_space(*p))
+			{
+				++p;
+			}
+		}
+		else
+		{
+			message("Character %c is not a hex number", ch);
+		}
+	}
+
+	return (const char*)p - src;
+}
+
+void hex_decoder::finish(string& out)
+{
+	if (m_pending >= 0)
+	{
+		out.push_back((char)(m_pending << 4));
+
+		m_pending = -1;
+	}
+}
+
+bool hex_filter::read(string& out)
+{
+	string_view src;
+	size_t len;
+
+	if (m_eof)
+	{
+		return false;
+	}
+
+	src = read_source();
+
+	if (src.empty())
+	{
+		// the source ended without '>'
+		m_decoder.finish(out);
+
+		m_eof = true;
+
+		return !out.empty();
+	}
+
+	len = m_decoder.decode(src.data(), src.size(), out);
+
+	skip_source(len);
+
+	if (m_decoder.eod())
+	{
+		m_decoder.finish(out);
+
+		m_eof = true;
+	}
+
+	return true;
+}
@@ -0,0 +1,130 @@
+/*
+//  Copyright (c) 2020 Peter Frane Jr. All Rights Reserved.
+//
+//  Use of this source code is governed by the GPL v. 3.0 license that can be
+//  found in the LICENSE file.
+//
+//  This software is distributed on an "AS IS" basis, WITHOUT WARRANTY
+//  OF ANY KIND, either express or implied.
+//
+//  For inquiries, email the author at pfranejr AT hotmail.com
+*/
+
+#pragma once
+#include "scanner.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HAS_SSE2
+#include <emmintrin.h>
+#endif
+
+// Streaming ASCII85 decoder; the input may be split anywhere, even inside a group.
+// decode() stops after the '~' of the EOD marker '~>'
+
+class ascii85_decoder : public common_class
+{
+	uint64_t m_tuple{ 0 };
+	int m_count{ 0 };
+	bool m_eod{ false };
+	void put_group(char* dst, uint64_t value);
+public:
+	ascii85_decoder() : common_class()
+	{
+	}
+	~ascii85_decoder()
+	{
+	}
+	// returns the number of bytes consumed
+	size_t decode(const char* src, size_t len, string& out);
+	// flushes a partial final group
+	void finish(string& out);
+	bool eod() const
+	{
+		return m_eod;
+	}
+};
+
+// Streaming ASCIIHex decoder; decode() stops after the EOD marker '>'
+
+class hex_decoder : public common_class
+{
+	int m_pending{ -1 }; // high nibble of an incomplete byte
+	bool m_eod{ false };
+public:
+	hex_decoder() : common_class()
+	{
+	}
+	~hex_decoder()
+	{
+	}
+	// returns the number of bytes consumed
+	size_t decode(const char* src, size_t len, string& out);
+	// an odd final digit is completed with 0
+	void finish(string& out);
+	bool eod() const
+	{
+		return m_eod;
+	}
+};
+
+// Source of a filter's data and the decoder; a filter scanner (scanner::load_filter) reads
+// the decoded data in chunks as the program consumes it
+
+class decode_filter : public common_class
+{
+protected:
+	scanner* m_source{ nullptr };
+	bool m_owns_source{ false };
+	string m_string; // copy of a string source
+	string_view m_unread; // the rest of m_string
+	bool m_eof{ false };
+	string_view read_source();
+	void skip_source(size_t len);
+public:
+	decode_filter(scanner* source, bool owns_source = false) : common_class(), m_source(source), m_owns_source(owns_source), m_string()
+	{
+	}
+	decode_filter(string_view source) : common_class(), m_string(source)
+	{
+		m_unread = m_string;
+	}
+	virtual ~decode_filter()
+	{
+		if (m_owns_source)
+		{
+			delete m_source;
+		}
+	}
+	// appends the next decoded chunk to 'out'; false at the end of the data
+	virtual bool read(string& out) = 0;
+	bool eof() const
+	{
+		return m_eof;
+	}
+};
+
+class ascii85_filter : public decode_filter
+{
+	ascii85_decoder m_decoder;
+public:
+	ascii85_filter(scanner* source) : decode_filter(source), m_decoder()
+	{
+	}
+	ascii85_filter(string_view source) : decode_filter(source), m_decoder()
+	{
+	}
+	bool read(string& out);
+};
+
+class hex_filter : public decode_filter
+{
+	hex_decoder m_decoder;
+public:
+	hex_filter(scanner* source) : decode_filter(source), m_decoder()
+	{
+	}
+	hex_filter(string_view source) : decode_filter(source), m_decoder()
+	{
+	}
+	bool read(string& out);
+};
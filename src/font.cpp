@@ -45,13 +45,13 @@ const base_font_table font_table[] =
 	{"Symbol", "Symbol", slant_type_normal, false}
 };
 
-const base_font_table *find_font_facename(const char* name)
+const base_font_table *find_font_facename(string_view name)
 {
 	size_t table_size = array_size(font_table);
 
 	for (size_t i = 0; i < table_size; ++i)
 	{
-		if (strcmp(font_table[i].m_key, name) == 0)
+		if (name == font_table[i].m_key)
 		{
 			return &font_table[i];
 		}
@@ -61,41 +61,32 @@ const base_font_table *find_font_facename(const char* name)
 	return &font_table[0];
 }
 
-void processor::do_findfont(operator_handler* handler)
+void processor::do_findfont(const operator_handler* handler)
 {
 	operand& op = m_operand_stack[0];
 
 	if (op.is_string_type())
 	{
-		string_type* str = op.as_string();
+		const base_font_table* font_obj = find_font_facename(op.string_value());
+		font_type* fnt = new font_type;
 
-		if (str)
+		if (!fnt)
 		{
-			const base_font_table* font_obj = find_font_facename(str->m_data.c_str());
-			font_type* fnt = new font_type;
-
-			if (!fnt)
-			{
-				message("Not enough memory to create a font object");
-			}
-			else
-			{
-				operand new_op(ot_font);
+			message("Not enough memory to create a font object");
+		}
+		else
+		{
+			operand new_op(ot_font);
 
-				fnt->m_name = font_obj->m_value;
-				fnt->m_bold = font_obj->m_bold;
-				fnt->m_slant_type = font_obj->m_slant_type;
+			fnt->m_name = font_obj->m_value;
+			fnt->m_bold = font_obj->m_bold;
+			fnt->m_slant_type = font_obj->m_slant_type;
 
-				new_op.m_object = fnt;
+			new_op.m_object = fnt;
 
-				pop();
+			pop();
 
-				push_operand(new_op);
-			}
-		}
-		else
-		{
-			message("Missing font name in --%s--", handler->m_name);
+			push_operand(new_op);
 		}
 	}
 	else
@@ -104,7 +95,7 @@ void processor::do_findfont(operator_handler* handler)
 	}
 }
 
-void processor::do_scalefont(operator_handler* handler)
+void processor::do_scalefont(const operator_handler* handler)
 {
 	operand& size = m_operand_stack[0];
 	
@@ -130,7 +121,7 @@ void processor::do_scalefont(operator_handler* handler)
 			}
 			else
 			{
-				font_type* fnt = dynamic_cast<font_type*>(font.m_object);
+				font_type* fnt = object_cast<font_type>(font.m_object);
 
 				if (!fnt)
 				{
@@ -152,13 +143,13 @@ error_msg:
 	message("Type check in --%s--", handler->m_name);
 }
 
-void processor::do_setfont(operator_handler* handler)
+void processor::do_setfont(const operator_handler* handler)
 {
 	operand& op = m_operand_stack[0];
 
 	if (op.is_font())
 	{
-		font_type* fnt = dynamic_cast<font_type*>(op.m_object);
+		font_type* fnt = object_cast<font_type>(op.m_object);
 
 		if (!fnt)
 		{
@@ -183,7 +174,7 @@ error_msg:
 	message("Type check in --%s--", handler->m_name);
 }
 
-void processor::do_selectfont(operator_handler* handler)
+void processor::do_selectfont(const operator_handler* handler)
 {
 	operand& size = m_operand_stack[0];
 	operand& font_name = m_operand_stack[1];
@@ -224,7 +215,7 @@ void processor::do_selectfont(operator_handler* handler)
 	}
 }
 
-void processor::do_show(operator_handler* handler)
+void processor::do_show(const operator_handler* handler)
 {
 	if (!has_current_point())
 	{
@@ -257,7 +248,7 @@ void processor::do_show(operator_handler* handler)
 	}
 }
 
-void processor::do_charpath(operator_handler* handler)
+void processor::do_charpath(const operator_handler* handler)
 {
 	if (!has_current_point())
 	{
@@ -292,7 +283,7 @@ void processor::do_charpath(operator_handler* handler)
 	}
 }
 
-void processor::do_string(operator_handler* handler)
+void processor::do_string(const operator_handler* handler)
 {
 	if (m_operand_stack[0].is_integer())
 	{
@@ -335,7 +326,7 @@ void processor::do_string(operator_handler* handler)
 	}
 }
 
-void processor::do_stringwidth(operator_handler* handler)
+void processor::do_stringwidth(const operator_handler* handler)
 {
 	operand& op1 = m_operand_stack[0];
 
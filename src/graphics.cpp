@@ -22,12 +22,12 @@ static double __clamp(double v)
 	return v;
 }
 
-void processor::do_showpage(operator_handler* handler)
+void processor::do_showpage(const operator_handler* handler)
 {
 	cairo_show_page(m_cairo);
 }
 
-void processor::do_setrgbcolor(operator_handler* handler)
+void processor::do_setrgbcolor(const operator_handler* handler)
 {
 	double b = __clamp(m_operand_stack[0].m_number);
 	double g = __clamp(m_operand_stack[1].m_number);
@@ -43,7 +43,7 @@ void processor::do_setrgbcolor(operator_handler* handler)
 	m_color.b = b;
 }
 
-void processor::do_setcmykcolor(operator_handler* handler)
+void processor::do_setcmykcolor(const operator_handler* handler)
 {
 	double k = __clamp(m_operand_stack[0].m_number);
 	double y = __clamp(m_operand_stack[1].m_number);
@@ -69,7 +69,7 @@ void processor::do_setcmykcolor(operator_handler* handler)
 	m_color.k = k;
 }
 
-void processor::do_setlinejoin(operator_handler* handler)
+void processor::do_setlinejoin(const operator_handler* handler)
 {
 	operand& op = m_operand_stack[0];
 
@@ -91,7 +91,7 @@ void processor::do_setlinejoin(operator_handler* handler)
 	}
 }
 
-void processor::do_setlinecap(operator_handler* handler)
+void processor::do_setlinecap(const operator_handler* handler)
 {
 	operand& op = m_operand_stack[0];
 
@@ -114,7 +114,7 @@ void processor::do_setlinecap(operator_handler* handler)
 	}
 }
 
-void processor::do_setdash(operator_handler* handler)
+void processor::do_setdash(const operator_handler* handler)
 {
 	operand& op1 = m_operand_stack[0];
 	operand& op2 = m_operand_stack[1];
@@ -175,7 +175,7 @@ void processor::do_setdash(operator_handler* handler)
 	message("Type check in --%s--", handler->m_name);
 }
 
-void processor::do_gsave(operator_handler* handler)
+void processor::do_gsave(const operator_handler* handler)
 {
 	gstate* gs = new gstate;
 
@@ -226,7 +226,7 @@ void processor::do_gsave(operator_handler* handler)
 	}	
 }
 
-void processor::do_grestore(operator_handler* handler)
+void processor::do_grestore(const operator_handler* handler)
 {
 	// empty if there was no prior 'gsave' call
 	if (!m_path_list.empty())
@@ -268,7 +268,7 @@ void processor::do_grestore(operator_handler* handler)
 	}
 }
 
-void processor::do_currentrgbcolor(operator_handler* handler)
+void processor::do_currentrgbcolor(const operator_handler* handler)
 {
 	operand op(ot_real);
 	double r{ 0 }, g{ 0 }, b{ 0 };
@@ -296,7 +296,7 @@ void processor::do_currentrgbcolor(operator_handler* handler)
 	push_operand(op);
 }
 
-void processor::do_currentcmykcolor(operator_handler* handler)
+void processor::do_currentcmykcolor(const operator_handler* handler)
 {
 	operand op(ot_real);
 	double c{ 0 }, m{ 0 }, y{ 0 }, k{ 0 };
@@ -338,7 +338,7 @@ void processor::do_currentcmykcolor(operator_handler* handler)
 	push_operand(op);
 }
 
-void processor::do_currentgray(operator_handler* handler)
+void processor::do_currentgray(const operator_handler* handler)
 {
 	operand op(ot_real);
 
@@ -357,7 +357,7 @@ void processor::do_currentgray(operator_handler* handler)
 	push_operand(op);
 }
 
-void processor::do_get_graphics_state(operator_handler* handler)
+void processor::do_get_graphics_state(const operator_handler* handler)
 {
 	operand op(ot_real);
 
@@ -388,7 +388,7 @@ void processor::do_get_graphics_state(operator_handler* handler)
 	}
 }
 
-void processor::do_set_graphics_state(operator_handler* handler)
+void processor::do_set_graphics_state(const operator_handler* handler)
 {
 	double value{ 0 };
 
@@ -481,7 +481,7 @@ size_t processor::get_transform_params(double& x, double& y, double* values, boo
 }
 
 
-void processor::do_matrix_transform(operator_handler* handler)
+void processor::do_matrix_transform(const operator_handler* handler)
 {
 	cairo_matrix_t mtx = m_ctm;
 	double x{ 0 }, y{ 0 };
@@ -518,7 +518,7 @@ void processor::do_matrix_transform(operator_handler* handler)
 }
 
 
-void processor::do_setmatrix(operator_handler* handler)
+void processor::do_setmatrix(const operator_handler* handler)
 {
 	operand& op = m_operand_stack[0];
 
@@ -534,7 +534,7 @@ void processor::do_setmatrix(operator_handler* handler)
 	}	
 }
 
-void processor::do_concat(operator_handler* handler)
+void processor::do_concat(const operator_handler* handler)
 {
 	operand& op = m_operand_stack[0];
 	cairo_matrix_t mtx;
@@ -557,7 +557,7 @@ void processor::do_concat(operator_handler* handler)
 	}
 }
 
-void processor::do_replace_matrix(operator_handler* handler)
+void processor::do_replace_matrix(const operator_handler* handler)
 {
 	operand &op = m_operand_stack[0];
 
@@ -600,7 +600,7 @@ void processor::do_replace_matrix(operator_handler* handler)
 	}
 }
 
-void processor::do_initmatrix(operator_handler* handler)
+void processor::do_initmatrix(const operator_handler* handler)
 {
 	cairo_matrix_t mtx1 = { m_scale, 0, 0, m_scale, 0, 0 };
 
@@ -609,7 +609,7 @@ void processor::do_initmatrix(operator_handler* handler)
 	cairo_set_matrix(m_cairo, &mtx1);
 }
 
-void processor::do_matrix(operator_handler* handler)
+void processor::do_matrix(const operator_handler* handler)
 {
 	const size_t matrix_size = 6;
 	double mtx[6] = { 1.0, 0, 0, 1.0, 0, 0 };
@@ -636,7 +636,7 @@ void processor::do_matrix(operator_handler* handler)
 	}
 }
 
-void processor::do_rotate(operator_handler* handler)
+void processor::do_rotate(const operator_handler* handler)
 {
 	operand& op1 = m_operand_stack[0];
 	double angle;
@@ -697,7 +697,7 @@ void processor::do_rotate(operator_handler* handler)
 	}
 }
 
-void processor::do_scale(operator_handler* handler)
+void processor::do_scale(const operator_handler* handler)
 {
 	const size_t matrix_size = 6;
 	double values[matrix_size];
@@ -746,7 +746,7 @@ void processor::do_scale(operator_handler* handler)
 	}
 }
 
-void processor::do_translate(operator_handler* handler)
+void processor::do_translate(const operator_handler* handler)
 {
 	const size_t matrix_size = 6;
 	double values[matrix_size];
@@ -795,7 +795,7 @@ void processor::do_translate(operator_handler* handler)
 	}
 }
 
-void processor::do_invertmatrix(operator_handler* handler)
+void processor::do_invertmatrix(const operator_handler* handler)
 {
 	const size_t matrix_size = 6;
 	operand& op2 = m_operand_stack[0];
@@ -826,7 +826,7 @@ void processor::do_invertmatrix(operator_handler* handler)
 	}
 }
 
-void processor::do_concatmatrix(operator_handler* handler)
+void processor::do_concatmatrix(const operator_handler* handler)
 {
 	const size_t matrix_size = 6;
 	operand& op3 = m_operand_stack[0];
@@ -0,0 +1,680 @@
+/*
+//  Copyright (c) 2020 Peter Frane Jr. All Rights Reserved.
+//
+//  Use of this source code is governed by the GPL v. 3.0 license that can be
+//  found in the LICENSE file.
+//
+//  This software is distributed on an "AS IS" basis, WITHOUT WARRANTY
+//  OF ANY KIND, either express or implied.
+//
+//  For inquiries, email the author at pfranejr AT hotmail.com
+*/
+
+#include "inflate.h"
+
+// decoded data is returned in chunks of about this size
+static constexpr size_t INFLATE_CHUNK_SIZE = 65536;
+
+static const uint16_t length_base[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const uint8_t length_extra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const uint16_t distance_base[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static const uint8_t distance_extra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+struct crc_table
+{
+	uint32_t m_value[256];
+};
+
+static constexpr crc_table make_crc_table()
+{
+	crc_table table{};
+
+	for (uint32_t i = 0; i < 256; ++i)
+	{
+		uint32_t c = i;
+
+		for (int k = 0; k < 8; ++k)
+		{
+			c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+		}
+		table.m_value[i] = c;
+	}
+
+	return table;
+}
+
+static constexpr crc_table crc_values = make_crc_table();
+
+bool huffman_code::build(const uint8_t* lengths, int count)
+{
+	uint16_t offsets[16]{ 0 };
+	uint16_t next_code[16]{ 0 };
+	int left = 1;
+
+	memset(m_count, 0, sizeof(m_count));
+	memset(m_fast, 0, sizeof(m_fast));
+
+	for (int i = 0; i < count; ++i)
+	{
+		++m_count[lengths[i]];
+	}
+	m_count[0] = 0;
+
+	// over-subscribed codes are invalid; incomplete ones are allowed
+	for (int len = 1; len < 16; ++len)
+	{
+		left <<= 1;
+		left -= m_count[len];
+
+		if (left < 0)
+		{
+			return false;
+		}
+	}
+
+	for (int len = 1; len < 15; ++len)
+	{
+		offsets[len + 1] = offsets[len] + m_count[len];
+	}
+	for (int len = 1, code = 0; len < 16; ++len)
+	{
+		code = (code + m_count[len - 1]) << 1;
+		next_code[len] = (uint16_t)code;
+	}
+
+	for (int symbol = 0; symbol < count; ++symbol)
+	{
+		int len = lengths[symbol];
+
+		if (0 == len)
+		{
+			continue;
+		}
+
+		m_symbol[offsets[len]++] = (uint16_t)symbol;
+
+		if (len <= INFLATE_FAST_BITS)
+		{
+			int code = next_code[len];
+			int reversed = 0;
+
+			// codes are stored starting with their most significant bit
+			for (int i = 0; i < len; ++i)
+			{
+				reversed = (reversed << 1) | ((code >> i) & 1);
+			}
+			for (int i = reversed; i < (1 << INFLATE_FAST_BITS); i += (1 << len))
+			{
+				m_fast[i] = (uint16_t)((symbol << 4) | len);
+			}
+		}
+		++next_code[len];
+	}
+
+	return true;
+}
+
+bool flate_filter::detect(const char* data, size_t len, compression_format& format)
+{
+	const uint8_t* p = (const uint8_t*)data;
+
+	if (len < 2)
+	{
+		return false;
+	}
+	if (0x1F == p[0] && 0x8B == p[1])
+	{
+		format = cf_gzip;
+
+		return true;
+	}
+	if (8 == (p[0] & 0x0F) && (p[0] >> 4) <= 7 && ((p[0] << 8) | p[1]) % 31 == 0)
+	{
+		format = cf_zlib;
+
+		return true;
+	}
+
+	return false;
+}
+
+// the next chunk of the source; the current one has been used up
+
+bool flate_filter::refill()
+{
+	string_view chunk;
+
+	skip_source(m_in - m_in_start);
+
+	chunk = read_source();
+
+	m_in_start = m_in = (const uint8_t*)chunk.data();
+	m_in_end = m_in + chunk.size();
+
+	return !chunk.empty();
+}
+
+// consumes exactly what was used from the source; whole bytes read ahead into
+// the bit buffer are given back. They always come from the current chunk
+
+void flate_filter::sync_input()
+{
+	size_t extra = m_bit_count / 8;
+
+	if (extra > (size_t)(m_in - m_in_start))
+	{
+		extra = m_in - m_in_start;
+	}
+
+	m_in -= extra;
+	m_bit_count -= (int)extra * 8;
+	m_bits &= (1u << m_bit_count) - 1;
+
+	skip_source(m_in - m_in_start);
+
+	m_in_start = m_in = m_in_end = nullptr;
+}
+
+uint8_t flate_filter::get_byte()
+{
+	if (m_bit_count >= 8)
+	{
+		uint8_t byte = (uint8_t)m_bits;
+
+		m_bits >>= 8;
+		m_bit_count -= 8;
+
+		return byte;
+	}
+	if (m_in == m_in_end && !refill())
+	{
+		message("Unexpected end of compressed data");
+	}
+
+	return *m_in++;
+}
+
+uint32_t flate_filter::get_bits(int count)
+{
+	uint32_t value;
+
+	while (m_bit_count < count)
+	{
+		if (m_in == m_in_end && !refill())
+		{
+			message("Unexpected end of compressed data");
+		}
+
+		m_bits |= (uint32_t)*m_in++ << m_bit_count;
+		m_bit_count += 8;
+	}
+
+	value = m_bits & ((1u << count) - 1);
+
+	m_bits >>= count;
+	m_bit_count -= count;
+
+	return value;
+}
+
+int flate_filter::decode(const huffman_code& code)
+{
+	int value = 0, first = 0, index = 0;
+
+	// look ahead only within the current chunk (see sync_input)
+	while (m_bit_count <= 16 && m_in < m_in_end)
+	{
+		m_bits |= (uint32_t)*m_in++ << m_bit_count;
+		m_bit_count += 8;
+	}
+
+	if (m_bit_count >= INFLATE_FAST_BITS)
+	{
+		uint16_t entry = code.m_fast[m_bits & ((1 << INFLATE_FAST_BITS) - 1)];
+
+		if (entry)
+		{
+			int len = entry & 15;
+
+			m_bits >>= len;
+			m_bit_count -= len;
+
+			return entry >> 4;
+		}
+	}
+
+	// long codes, or the end of the input is near
+	for (int len = 1; len < 16; ++len)
+	{
+		int count = code.m_count[len];
+
+		value |= get_bits(1);
+
+		if (value - first < count)
+		{
+			return code.m_symbol[index + value - first];
+		}
+
+		index += count;
+		first += count;
+		first <<= 1;
+		value <<= 1;
+	}
+
+	message("Invalid Huffman code in compressed data");
+
+	return -1;
+}
+
+inline void flate_filter::put(string& out, uint8_t byte)
+{
+	out.push_back((char)byte);
+
+	m_window[m_window_pos++ & (INFLATE_WINDOW_SIZE - 1)] = byte;
+}
+
+void flate_filter::update_checks(const char* data, size_t len)
+{
+	const uint8_t* p = (const uint8_t*)data;
+
+	m_total += (uint32_t)len;
+
+	if (cf_gzip == m_format)
+	{
+		uint32_t crc = ~m_crc;
+
+		for (size_t i = 0; i < len; ++i)
+		{
+			crc = crc_values.m_value[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+		}
+
+		m_crc = ~crc;
+	}
+	else if (cf_zlib == m_format)
+	{
+		uint32_t a = m_adler & 0xFFFF;
+		uint32_t b = m_adler >> 16;
+
+		while (len > 0)
+		{
+			// largest n such that the sums can't overflow before the modulo
+			size_t n = len < 5552 ? len : 5552;
+
+			len -= n;
+
+			while (n--)
+			{
+				a += *p++;
+				b += a;
+			}
+
+			a %= 65521;
+			b %= 65521;
+		}
+
+		m_adler = (b << 16) | a;
+	}
+}
+
+void flate_filter::read_header()
+{
+	if (cf_auto == m_format)
+	{
+		if (m_in == m_in_end)
+		{
+			refill();
+		}
+		// the white space ending the token before the data (e.g. 'exec'); it can't start a zlib header
+		if (m_source && m_in < m_in_end && memchr(" \t\r\n\f", *m_in, 5))
+		{
+			if ('\r' == *m_in++ && m_in < m_in_end && '\n' == *m_in)
+			{
+				++m_in;
+			}
+		}
+		if (!detect((const char*)m_in, m_in_end - m_in, m_format) || m_format != cf_zlib)
+		{
+			m_format = cf_raw;
+		}
+	}
+
+	if (cf_zlib == m_format)
+	{
+		uint8_t cmf = get_byte();
+		uint8_t flags = get_byte();
+
+		if ((cmf & 0x0F) != 8 || ((cmf << 8) | flags) % 31 != 0)
+		{
+			message("Invalid zlib header");
+		}
+		if (flags & 0x20)
+		{
+			message("zlib streams with a preset dictionary are not supported");
+		}
+	}
+	else if (cf_gzip == m_format)
+	{
+		uint8_t flags;
+
+		if (get_byte() != 0x1F || get_byte() != 0x8B || get_byte() != 8)
+		{
+			message("Invalid gzip header");
+		}
+
+		flags = get_byte();
+
+		// modification time, extra flags, operating system
+		for (int i = 0; i < 6; ++i)
+		{
+			get_byte();
+		}
+		if (flags & 0x04) // extra field
+		{
+			uint32_t len = get_byte();
+
+			len |= (uint32_t)get_byte() << 8;
+
+			while (len--)
+			{
+				get_byte();
+			}
+		}
+		if (flags & 0x08) // file name
+		{
+			while (get_byte() != 0)
+			{
+			}
+		}
+		if (flags & 0x10) // comment
+		{
+			while (get_byte() != 0)
+			{
+			}
+		}
+		if (flags & 0x02) // header CRC
+		{
+			get_byte();
+			get_byte();
+		}
+	}
+
+	m_crc = 0;
+	m_adler = 1;
+	m_total = 0;
+}
+
+void flate_filter::read_dynamic_codes()
+{
+	static const uint8_t order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+	uint8_t lengths[320]{ 0 };
+	huffman_code length_code;
+	int literal_count = get_bits(5) + 257;
+	int distance_count = get_bits(5) + 1;
+	int code_count = get_bits(4) + 4;
+	int index = 0;
+
+	if (literal_count > 286 || distance_count > 30)
+	{
+		message("Invalid code counts in compressed data");
+	}
+
+	for (int i = 0; i < code_count; ++i)
+	{
+		lengths[order[i]] = (uint8_t)get_bits(3);
+	}
+
+	if (!length_code.build(lengths, 19))
+	{
+		message("Invalid code lengths in compressed data");
+	}
+
+	memset(lengths, 0, sizeof(lengths));
+
+	while (index < literal_count + distance_count)
+	{
+		int symbol = decode(length_code);
+		int repeat;
+		uint8_t len = 0;
+
+		if (symbol < 16)
+		{
+			lengths[index++] = (uint8_t)symbol;
+
+			continue;
+		}
+		else if (16 == symbol)
+		{
+			if (0 == index)
+			{
+				message("Invalid code lengths in compressed data");
+			}
+			len = lengths[index - 1];
+			repeat = 3 + get_bits(2);
+		}
+		else if (17 == symbol)
+		{
+			repeat = 3 + get_bits(3);
+		}
+		else
+		{
+			repeat = 11 + get_bits(7);
+		}
+
+		if (index + repeat > literal_count + distance_count)
+		{
+			message("Invalid code lengths in compressed data");
+		}
+		while (repeat--)
+		{
+			lengths[index++] = len;
+		}
+	}
+
+	if (0 == lengths[256] || !m_literals.build(lengths, literal_count) || !m_distances.build(lengths + literal_count, distance_count))
+	{
+		message("Invalid Huffman codes in compressed data");
+	}
+}
+
+void flate_filter::read_block_header()
+{
+	m_last_block = get_bits(1) != 0;
+
+	switch (get_bits(2))
+	{
+	case 0:
+		{
+			uint32_t len, complement;
+
+			// to a byte boundary
+			m_bits >>= m_bit_count & 7;
+			m_bit_count -= m_bit_count & 7;
+
+			len = get_bits(16);
+			complement = get_bits(16);
+
+			if (len != (~complement & 0xFFFF))
+			{
+				message("Invalid stored block in compressed data");
+			}
+
+			m_stored_left = len;
+			m_state = is_stored;
+		}
+		break;
+	case 1:
+		{
+			uint8_t lengths[288 + 30];
+
+			memset(lengths, 8, 144);
+			memset(lengths + 144, 9, 112);
+			memset(lengths + 256, 7, 24);
+			memset(lengths + 280, 8, 8);
+			memset(lengths + 288, 5, 30);
+
+			m_literals.build(lengths, 288);
+			m_distances.build(lengths + 288, 30);
+
+			m_state = is_huffman;
+		}
+		break;
+	case 2:
+		read_dynamic_codes();
+		m_state = is_huffman;
+		break;
+	default:
+		message("Invalid block type in compressed data");
+		break;
+	}
+}
+
+void flate_filter::read_trailer()
+{
+	uint32_t value = 0;
+
+	// to a byte boundary
+	m_bits >>= m_bit_count & 7;
+	m_bit_count -= m_bit_count & 7;
+
+	m_state = is_done;
+
+	if (cf_zlib == m_format)
+	{
+		for (int i = 0; i < 4; ++i)
+		{
+			value = (value << 8) | get_byte();
+		}
+		if (value != m_adler)
+		{
+			message("Compressed data is corrupt (Adler-32 mismatch)");
+		}
+	}
+	else if (cf_gzip == m_format)
+	{
+		uint32_t size = 0;
+
+		for (int i = 0; i < 4; ++i)
+		{
+			value |= (uint32_t)get_byte() << (8 * i);
+		}
+		for (int i = 0; i < 4; ++i)
+		{
+			size |= (uint32_t)get_byte() << (8 * i);
+		}
+		if (value != m_crc || size != m_total)
+		{
+			message("Compressed data is corrupt (CRC-32 mismatch)");
+		}
+
+		// concatenated gzip members form one stream
+		if (0 == m_bit_count && (m_in < m_in_end || refill()) && m_in_end - m_in >= 2 && 0x1F == m_in[0] && 0x8B == m_in[1])
+		{
+			m_state = is_header;
+		}
+	}
+}
+
+bool flate_filter::read(string& out)
+{
+	size_t start = out.size();
+	size_t checked = start;
+
+	if (m_eof)
+	{
+		return false;
+	}
+
+	while (m_state != is_done && out.size() - start < INFLATE_CHUNK_SIZE)
+	{
+		switch (m_state)
+		{
+		case is_header:
+			read_header();
+			m_state = is_block_header;
+			break;
+		case is_block_header:
+			read_block_header();
+			break;
+		case is_stored:
+			while (m_stored_left > 0 && out.size() - start < INFLATE_CHUNK_SIZE)
+			{
+				put(out, get_byte());
+
+				--m_stored_left;
+			}
+			if (0 == m_stored_left)
+			{
+				m_state = m_last_block ? is_trailer : is_block_header;
+			}
+			break;
+		case is_huffman:
+			while (out.size() - start < INFLATE_CHUNK_SIZE)
+			{
+				int symbol = decode(m_literals);
+
+				if (symbol < 256)
+				{
+					put(out, (uint8_t)symbol);
+				}
+				else if (256 == symbol)
+				{
+					m_state = m_last_block ? is_trailer : is_block_header;
+
+					break;
+				}
+				else
+				{
+					int len, distance_symbol;
+					size_t distance;
+
+					symbol -= 257;
+
+					if (symbol >= 29)
+					{
+						message("Invalid length in compressed data");
+					}
+
+					len = length_base[symbol] + get_bits(length_extra[symbol]);
+
+					distance_symbol = decode(m_distances);
+
+					if (distance_symbol >= 30)
+					{
+						message("Invalid distance in compressed data");
+					}
+
+					distance = distance_base[distance_symbol] + get_bits(distance_extra[distance_symbol]);
+
+					if (distance > m_window_pos || distance > INFLATE_WINDOW_SIZE)
+					{
+						message("Invalid distance in compressed data");
+					}
+
+					while (len--)
+					{
+						put(out, m_window[(m_window_pos - distance) & (INFLATE_WINDOW_SIZE - 1)]);
+					}
+				}
+			}
+			break;
+		case is_trailer:
+			update_checks(out.data() + checked, out.size() - checked);
+			checked = out.size();
+			read_trailer();
+			break;
+		default:
+			break;
+		}
+	}
+
+	update_checks(out.data() + checked, out.size() - checked);
+
+	sync_input();
+
+	if (is_done == m_state)
+	{
+		m_eof = true;
+	}
+
+	return out.size() > start || !m_eof;
+}
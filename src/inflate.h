@@ -0,0 +1,97 @@
+/*
+//  Copyright (c) 2020 Peter Frane Jr. All Rights Reserved.
+//
+//  Use of this source code is governed by the GPL v. 3.0 license that can be
+//  found in the LICENSE file.
+//
+//  This software is distributed on an "AS IS" basis, WITHOUT WARRANTY
+//  OF ANY KIND, either express or implied.
+//
+//  For inquiries, email the author at pfranejr AT hotmail.com
+*/
+
+#pragma once
+#include "filter.h"
+
+#define INFLATE_FAST_BITS 9
+#define INFLATE_WINDOW_SIZE 32768
+
+// canonical Huffman code of a deflate block
+
+struct huffman_code
+{
+	uint16_t m_count[16]{ 0 }; // number of codes of each length
+	uint16_t m_symbol[288]{ 0 }; // symbols ordered by code
+	uint16_t m_fast[1 << INFLATE_FAST_BITS]{ 0 }; // (symbol << 4) | length of short codes, by reversed code
+	bool build(const uint8_t* lengths, int count);
+};
+
+enum compression_format
+{
+	cf_auto, // zlib if the header says so, otherwise raw deflate
+	cf_raw,
+	cf_zlib,
+	cf_gzip
+};
+
+// Streaming inflate (RFC 1951) with the zlib (RFC 1950) and gzip (RFC 1952)
+// wrappers. Compressed data is pulled from the source as needed, and only
+// what was used is consumed from it, so a stream embedded in a file leaves
+// the file positioned right after it
+
+class flate_filter : public decode_filter
+{
+	enum inflate_state
+	{
+		is_header,
+		is_block_header,
+		is_stored,
+		is_huffman,
+		is_trailer,
+		is_done
+	};
+	compression_format m_format;
+	inflate_state m_state{ is_header };
+	// input
+	const uint8_t* m_in{ nullptr };
+	const uint8_t* m_in_start{ nullptr };
+	const uint8_t* m_in_end{ nullptr };
+	uint32_t m_bits{ 0 };
+	int m_bit_count{ 0 };
+	// current block
+	bool m_last_block{ false };
+	size_t m_stored_left{ 0 };
+	huffman_code m_literals;
+	huffman_code m_distances;
+	// history for back references
+	vector<uint8_t> m_window;
+	size_t m_window_pos{ 0 };
+	// checks
+	uint32_t m_crc{ 0 };
+	uint32_t m_adler{ 1 };
+	uint32_t m_total{ 0 };
+
+	bool refill();
+	void sync_input();
+	uint8_t get_byte();
+	uint32_t get_bits(int count);
+	int decode(const huffman_code& code);
+	void put(string& out, uint8_t byte);
+	void read_header();
+	void read_block_header();
+	void read_dynamic_codes();
+	void read_trailer();
+	void update_checks(const char* data, size_t len);
+public:
+	flate_filter(scanner* source, compression_format format, bool owns_source = false) : decode_filter(source, owns_source), m_format(format), m_literals(), m_distances(), m_window()
+	{
+		m_window.resize(INFLATE_WINDOW_SIZE);
+	}
+	flate_filter(string_view source, compression_format format) : decode_filter(source), m_format(format), m_literals(), m_distances(), m_window()
+	{
+		m_window.resize(INFLATE_WINDOW_SIZE);
+	}
+	bool read(string& out);
+	// true if 'data' starts with a gzip or zlib header
+	static bool detect(const char* data, size_t len, compression_format& format);
+};
@@ -13,7 +13,7 @@
 
 #include "processor.h"
 
-void processor::do_eq(operator_handler* handler)
+void processor::do_eq(const operator_handler* handler)
 {
 	operand& second = m_operand_stack[0];
 	operand& first = m_operand_stack[1];
@@ -24,15 +24,13 @@ void processor::do_eq(operator_handler* handler)
 	{
 		result = first.m_number == second.m_number;
 	}
+	else if (first.is_literal() && second.is_literal())
+	{
+		result = first.m_atom == second.m_atom;
+	}
 	else if (first.is_string_type() && second.is_string_type())
 	{
-		string_type* s1 = first.as_string();
-		string_type* s2 = second.as_string();
-
-		if (s1 && s2)
-		{
-			result = s1->compare(s2) == 0;
-		}
+		result = first.string_value() == second.string_value();
 	}
 	else if (first.m_type == second.m_type)
 	{		
@@ -53,7 +51,7 @@ void processor::do_eq(operator_handler* handler)
 	push_operand(eq);
 }
 
-void processor::do_ne(operator_handler* handler)
+void processor::do_ne(const operator_handler* handler)
 {
 	do_eq(handler);
 
@@ -62,7 +60,7 @@ void processor::do_ne(operator_handler* handler)
 	m_operand_stack[0].m_bool = !m_operand_stack[0].m_bool;
 }
 
-void processor::do_lt(operator_handler* handler)
+void processor::do_lt(const operator_handler* handler)
 {
 	operand& second = m_operand_stack[0];
 	operand& first = m_operand_stack[1];
@@ -98,7 +96,7 @@ void processor::do_lt(operator_handler* handler)
 
 }
 
-void processor::do_le(operator_handler* handler)
+void processor::do_le(const operator_handler* handler)
 {
 	operand& second = m_operand_stack[0];
 	operand& first = m_operand_stack[1];
@@ -134,7 +132,7 @@ void processor::do_le(operator_handler* handler)
 
 }
 
-void processor::do_gt(operator_handler* handler)
+void processor::do_gt(const operator_handler* handler)
 {
 	operand& second = m_operand_stack[0];
 	operand& first = m_operand_stack[1];
@@ -170,7 +168,7 @@ void processor::do_gt(operator_handler* handler)
 
 }
 
-void processor::do_ge(operator_handler* handler)
+void processor::do_ge(const operator_handler* handler)
 {
 	operand& second = m_operand_stack[0];
 	operand& first = m_operand_stack[1];
@@ -206,7 +204,7 @@ void processor::do_ge(operator_handler* handler)
 
 }
 
-void processor::do_true(operator_handler* handler)
+void processor::do_true(const operator_handler* handler)
 {
 	operand op(ot_boolean);
 
@@ -215,7 +213,7 @@ void processor::do_true(operator_handler* handler)
 	push_operand(op);
 }
 
-void processor::do_false(operator_handler* handler)
+void processor::do_false(const operator_handler* handler)
 {
 	operand op(ot_boolean);
 
@@ -224,7 +222,7 @@ void processor::do_false(operator_handler* handler)
 	push_operand(op);
 }
 
-void processor::do_if(operator_handler* handler)
+void processor::do_if(const operator_handler* handler)
 {
 	operand& proc = m_operand_stack[0];
 	operand& condition = m_operand_stack[1];
@@ -235,19 +233,17 @@ void processor::do_if(operator_handler* handler)
 	}
 	else
 	{
-		operand pr = m_operand_stack[0];
-		operand con = m_operand_stack[1];
+		operand pr = pop_operand();
+		bool con = pop_operand().m_bool;
 
-		pop(2);
-
-		if (con.m_bool)
+		if (con)
 		{
 			execute_procedure(pr);
 		}
 	}
 }
 
-void processor::do_ifelse(operator_handler* handler)
+void processor::do_ifelse(const operator_handler* handler)
 {
 	operand& proc2 = m_operand_stack[0];
 	operand& proc1 = m_operand_stack[1];
@@ -259,13 +255,11 @@ void processor::do_ifelse(operator_handler* handler)
 	}
 	else
 	{
-		operand pr2 = m_operand_stack[0];
-		operand pr1 = m_operand_stack[1];
-		operand con = m_operand_stack[2];
-
-		pop(3);
+		operand pr2 = pop_operand();
+		operand pr1 = pop_operand();
+		bool con = pop_operand().m_bool;
 
-		if (con.m_bool)
+		if (con)
 		{
 			execute_procedure(pr1);
 		}
@@ -276,7 +270,7 @@ void processor::do_ifelse(operator_handler* handler)
 	}
 }
 
-void processor::do_logic_misc_ops(operator_handler* handler)
+void processor::do_logic_misc_ops(const operator_handler* handler)
 {
 	operand op1, op2;
 	bool is_number{ false };
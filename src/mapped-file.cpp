@@ -0,0 +1,144 @@
+/*
+//  Copyright (c) 2020 Peter Frane Jr. All Rights Reserved.
+//
+//  Use of this source code is governed by the GPL v. 3.0 license that can be
+//  found in the LICENSE file.
+//
+//  This software is distributed on an "AS IS" basis, WITHOUT WARRANTY
+//  OF ANY KIND, either express or implied.
+//
+//  For inquiries, email the author at pfranejr AT hotmail.com
+*/
+
+#include "mapped-file.h"
+#include <stdint.h>
+
+#ifdef _WIN32
+#include <windows.h>
+
+bool mapped_file::open(const char* filename)
+{
+	LARGE_INTEGER file_size;
+	HANDLE file, mapping;
+	void* data;
+
+	close();
+
+	file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+	if (INVALID_HANDLE_VALUE == file)
+	{
+		return false;
+	}
+	// pipes and devices are read with fgets()
+	if (GetFileType(file) != FILE_TYPE_DISK || !GetFileSizeEx(file, &file_size) || 0 == file_size.QuadPart || (uint64_t)file_size.QuadPart > (uint64_t)SIZE_MAX)
+	{
+		CloseHandle(file);
+
+		return false;
+	}
+
+	mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+	if (!mapping)
+	{
+		CloseHandle(file);
+
+		return false;
+	}
+
+	data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+
+	if (!data)
+	{
+		CloseHandle(mapping);
+		CloseHandle(file);
+
+		return false;
+	}
+
+	m_file = file;
+	m_mapping = mapping;
+	m_data = (const char*)data;
+	m_size = (size_t)file_size.QuadPart;
+
+	return true;
+}
+
+void mapped_file::close()
+{
+	if (m_data)
+	{
+		UnmapViewOfFile(m_data);
+	}
+	if (m_mapping)
+	{
+		CloseHandle((HANDLE)m_mapping);
+	}
+	if (m_file)
+	{
+		CloseHandle((HANDLE)m_file);
+	}
+	m_file = nullptr;
+	m_mapping = nullptr;
+	m_data = nullptr;
+	m_size = 0;
+}
+
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+bool mapped_file::open(const char* filename)
+{
+	struct stat st;
+	void* data;
+	int fd;
+
+	close();
+
+	fd = ::open(filename, O_RDONLY);
+
+	if (fd < 0)
+	{
+		return false;
+	}
+	// pipes and devices are read with fgets()
+	if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || 0 == st.st_size)
+	{
+		::close(fd);
+
+		return false;
+	}
+
+	data = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+	// the mapping stays valid after the descriptor is closed
+	::close(fd);
+
+	if (MAP_FAILED == data)
+	{
+		return false;
+	}
+
+	madvise(data, (size_t)st.st_size, MADV_SEQUENTIAL);
+
+	m_data = (const char*)data;
+	m_size = (size_t)st.st_size;
+
+	return true;
+}
+
+void mapped_file::close()
+{
+	if (m_data)
+	{
+		munmap((void*)m_data, m_size);
+	}
+	m_data = nullptr;
+	m_size = 0;
+}
+
+#endif
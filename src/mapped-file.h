@@ -0,0 +1,46 @@
+/*
+//  Copyright (c) 2020 Peter Frane Jr. All Rights Reserved.
+//
+//  Use of this source code is governed by the GPL v. 3.0 license that can be
+//  found in the LICENSE file.
+//
+//  This software is distributed on an "AS IS" basis, WITHOUT WARRANTY
+//  OF ANY KIND, either express or implied.
+//
+//  For inquiries, email the author at pfranejr AT hotmail.com
+*/
+
+#pragma once
+#include <stddef.h>
+
+// read-only view of a whole file; only regular, non-empty files can be mapped
+
+class mapped_file
+{
+	void* m_file{ nullptr };
+	void* m_mapping{ nullptr };
+	const char* m_data{ nullptr };
+	size_t m_size{ 0 };
+public:
+	mapped_file()
+	{
+	}
+	~mapped_file()
+	{
+		close();
+	}
+	bool open(const char* filename);
+	void close();
+	bool is_open() const
+	{
+		return m_data != nullptr;
+	}
+	const char* data() const
+	{
+		return m_data;
+	}
+	size_t size() const
+	{
+		return m_size;
+	}
+};
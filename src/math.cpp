@@ -27,7 +27,7 @@ double __rad2deg(double v)
 
 static int subcount = 0;
 
-void processor::do_math_binary_ops(operator_handler* handler)
+void processor::do_math_binary_ops(const operator_handler* handler)
 {
 	operand op2 = m_operand_stack[0];
 	operand op1 = m_operand_stack[1];
@@ -102,7 +102,7 @@ void processor::do_math_binary_ops(operator_handler* handler)
 }
 
 
-void processor::do_math_unary_ops(operator_handler* handler)
+void processor::do_math_unary_ops(const operator_handler* handler)
 {
 	operand& op = m_operand_stack[0];
 	double& number = op.m_number;
@@ -150,7 +150,7 @@ void processor::do_math_unary_ops(operator_handler* handler)
 	}
 }
 
-void processor::do_math_misc_ops(operator_handler* handler)
+void processor::do_math_misc_ops(const operator_handler* handler)
 {
 	const int rand_max = (int)(pow(2, 31) - 1);
 	switch (handler->m_op_id)
@@ -13,8 +13,10 @@
 
 
 #include "processor.h"
+#include "filter.h"
+#include "inflate.h"
 
-void processor::do_misc_ops(operator_handler* handler)
+void processor::do_misc_ops(const operator_handler* handler)
 {
 	switch (handler->m_op_id)
 	{
@@ -44,7 +46,7 @@ void processor::do_misc_ops(operator_handler* handler)
 	}
 }
 
-void processor::do_setglobal(operator_handler* handler)
+void processor::do_setglobal(const operator_handler* handler)
 {
 	operand& op = m_operand_stack[0];
 
@@ -60,7 +62,7 @@ void processor::do_setglobal(operator_handler* handler)
 	}
 }
 
-void processor::do_setpagedevice(operator_handler* handler)
+void processor::do_setpagedevice(const operator_handler* handler)
 {
 	operand& op = m_operand_stack[0];
 
@@ -73,7 +75,7 @@ void processor::do_setpagedevice(operator_handler* handler)
 			dictionary_type* d = static_cast<dictionary_type*>(dct);
 			operand value;
 
-			if (d->find("PageSize", value))
+			if (d->find(intern("PageSize"), value))
 			{
 				if (value.is_array())
 				{
@@ -109,7 +111,7 @@ void processor::do_setpagedevice(operator_handler* handler)
 
 }
 
-void processor::do_cvs(operator_handler* handler)
+void processor::do_cvs(const operator_handler* handler)
 {
 	operand& op1 = m_operand_stack[0];
 	operand& op2 = m_operand_stack[1];
@@ -170,32 +172,24 @@ void processor::do_cvs(operator_handler* handler)
 			}
 			else
 			{
-				string_type* src = op2.as_string();
+				string_view src = op2.string_value();
 
-				if (src)
-				{
-					src_len = (size_t)src->size();
+				src_len = src.size();
 
-					if (src_len <= dest_len)
-					{
-						operand result = op1;
-						string& dest_str = str->m_data;
-						string& tmp = src->m_data;
+				if (src_len <= dest_len)
+				{
+					operand result = op1;
+					string& dest_str = str->m_data;
 
-						dest_str.replace(0, src_len, tmp);
+					dest_str.replace(0, src_len, src);
 
-						pop(2);
+					pop(2);
 
-						push_operand(result);
-					}
-					else
-					{
-						message("Range check in --cvs--");
-					}
+					push_operand(result);
 				}
 				else
 				{
-					message("Type check in --cvs--");
+					message("Range check in --cvs--");
 				}
 			}
 		}
@@ -210,7 +204,7 @@ void processor::do_cvs(operator_handler* handler)
 	}
 }
 
-void processor::do_cvx(operator_handler* handler)
+void processor::do_cvx(const operator_handler* handler)
 {
 	operand& op = m_operand_stack[0];
 	operand_type type = op.m_type;
@@ -235,7 +229,7 @@ void processor::do_cvx(operator_handler* handler)
 
 }
 
-void processor::do_exec(operator_handler* handler)
+void processor::do_exec(const operator_handler* handler)
 {
 	operand& op = m_operand_stack[0];
 
@@ -245,14 +239,7 @@ void processor::do_exec(operator_handler* handler)
 
 		pop();
 
-		if (name.m_object)
-		{
-			string_type* str = dynamic_cast<string_type*>(name.m_object);
-			if (str)
-			{
-				do_name(str->data(), name.m_type);
-			}
-		}
+		do_name(name.m_atom, name.m_type);
 	}
 	else if (op.is_procedure())
 	{
@@ -262,6 +249,14 @@ void processor::do_exec(operator_handler* handler)
 
 		execute_procedure(name);
 	}
+	else if (op.is_file())
+	{
+		scanner* scr = op.m_scanner;
+
+		pop();
+
+		execute_file(scr);
+	}
 	else if (op.is_text_string())
 	{
 		//todo
@@ -269,7 +264,55 @@ void processor::do_exec(operator_handler* handler)
 	}
 }
 
-void processor::do_token(operator_handler* handler)
+// counts the inputs other than the main one being read; see create_array()
+
+struct nested_input
+{
+	int& m_depth;
+	nested_input(int& depth) : m_depth(depth)
+	{
+		++m_depth;
+	}
+	~nested_input()
+	{
+		--m_depth;
+	}
+};
+
+// runs the tokens of a file (usually a filter) until its end
+
+void processor::execute_file(scanner* scr)
+{
+	nested_input nested(m_nested_input);
+	token tkn;
+
+	while (!scr->is_eof())
+	{
+		bool error = false;
+
+		if (scr->get_token(tkn, error))
+		{
+			if (!process_token(tkn))
+			{
+				if (has_error())
+				{
+					throw runtime_error(m_error);
+				}
+				break;
+			}
+		}
+		else if (error)
+		{
+			message("%s", scr->error().c_str());
+		}
+		else
+		{
+			break;
+		}
+	}
+}
+
+void processor::do_token(const operator_handler* handler)
 {
 	operand& op = m_operand_stack[0];
 
@@ -283,6 +326,8 @@ void processor::do_token(operator_handler* handler)
 
 		if (scr->has_token(tkn))
 		{
+			nested_input nested(m_nested_input);
+
 			// pretend to be in a procedure to avoid executing names, except for constants
 			temp_procedure(true);
 
@@ -311,7 +356,91 @@ void processor::do_token(operator_handler* handler)
 	}
 }
 
-void processor::do_currentfile(operator_handler* handler)
+// src /name filter, or src dict /name filter; name is ASCII85Decode, ASCIIHexDecode or FlateDecode
+// the result is a file that can be read with 'token' or run with 'exec'
+
+void processor::do_filter(const operator_handler* handler)
+{
+	operand& name = m_operand_stack[0];
+	size_t src_index = 1;
+
+	if (!name.is_literal())
+	{
+		message("Type check in --%s--", handler->m_name);
+	}
+	if (m_operand_stack[1].is_dictionary())
+	{
+		if (stack_size() < 3)
+		{
+			message("Stack underflow in --%s--", handler->m_name);
+		}
+		src_index = 2;
+	}
+
+	string_view filter_name = name.string_value();
+	operand& src = m_operand_stack[src_index];
+	decode_filter* filter = nullptr;
+
+	if (!src.is_file() && !src.is_text_string())
+	{
+		message("Type check in --%s--", handler->m_name);
+	}
+
+	if (filter_name == "ASCII85Decode" || filter_name == "A85")
+	{
+		if (src.is_file())
+		{
+			filter = new ascii85_filter(src.m_scanner);
+		}
+		else
+		{
+			filter = new ascii85_filter(src.as_string()->m_data);
+		}
+	}
+	else if (filter_name == "ASCIIHexDecode" || filter_name == "AHx")
+	{
+		if (src.is_file())
+		{
+			filter = new hex_filter(src.m_scanner);
+		}
+		else
+		{
+			filter = new hex_filter(src.as_string()->m_data);
+		}
+	}
+	else if (filter_name == "FlateDecode" || filter_name == "Fl")
+	{
+		// zlib data, or a raw deflate stream
+		if (src.is_file())
+		{
+			filter = new flate_filter(src.m_scanner, cf_auto);
+		}
+		else
+		{
+			filter = new flate_filter(src.as_string()->m_data, cf_auto);
+		}
+	}
+	else
+	{
+		message("Unsupported filter in --%s--: %.*s", handler->m_name, (int)filter_name.size(), filter_name.data());
+	}
+
+	scanner* scr = new scanner;
+
+	m_filter_list.push_back(scr);
+
+	scr->load_filter(filter);
+
+	operand op(ot_file);
+
+	op.m_scanner = scr;
+
+	pop(src_index + 1);
+
+	push_operand(op);
+}
+
+void processor::do_currentfile(const operator_handler* handler)
 {
 	operand op(ot_file);
 
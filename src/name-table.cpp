@@ -0,0 +1,52 @@
+/*
+//  Copyright (c) 2020 Peter Frane Jr. All Rights Reserved.
+//
+//  Use of this source code is governed by the GPL v. 3.0 license that can be
+//  found in the LICENSE file.
+//
+//  This software is distributed on an "AS IS" basis, WITHOUT WARRANTY
+//  OF ANY KIND, either express or implied.
+//
+//  For inquiries, email the author at pfranejr AT hotmail.com
+*/
+
+#include "name-table.h"
+
+name_table& name_table::instance()
+{
+	static name_table table;
+
+	return table;
+}
+
+atom name_table::intern(string_view name)
+{
+	int index = builtin_name_index(name);
+	auto it = m_index.end();
+
+	if (index >= 0)
+	{
+		return (atom)index;
+	}
+
+	it = m_index.find(name);
+
+	if (it != m_index.end())
+	{
+		return it->second;
+	}
+	else
+	{
+		atom id = m_first + (atom)m_names.size();
+		string_view stored;
+
+		m_storage.emplace_back(name);
+
+		stored = m_storage.back();
+
+		m_names.push_back(stored);
+		m_index.emplace(stored, id);
+
+		return id;
+	}
+}
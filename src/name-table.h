@@ -0,0 +1,65 @@
+/*
+//  Copyright (c) 2020 Peter Frane Jr. All Rights Reserved.
+//
+//  Use of this source code is governed by the GPL v. 3.0 license that can be
+//  found in the LICENSE file.
+//
+//  This software is distributed on an "AS IS" basis, WITHOUT WARRANTY
+//  OF ANY KIND, either express or implied.
+//
+//  For inquiries, email the author at pfranejr AT hotmail.com
+*/
+
+#pragma once
+#include <string>
+#include <string_view>
+#include <deque>
+#include <vector>
+#include <unordered_map>
+#include <inttypes.h>
+
+using namespace std;
+
+using atom = uint32_t;
+
+// the names of the system dictionary (system-dictionary.cpp); their atoms are
+// their indices, fixed at compile time
+int builtin_name_index(string_view name);
+string_view builtin_name(atom id);
+atom builtin_name_count();
+
+// Every distinct name is stored once and identified by its atom, a small integer.
+// Name and literal operands hold the atom, so comparing them, hashing them and
+// using them as dictionary keys are integer operations
+
+class name_table
+{
+	deque<string> m_storage; // elements never move, so the views stay valid
+	vector<string_view> m_names; // by atom, after the system names
+	unordered_map<string_view, atom> m_index;
+	atom m_first{ builtin_name_count() };
+public:
+	name_table() : m_storage(), m_names(), m_index()
+	{
+	}
+	atom intern(string_view name);
+	string_view name(atom id) const
+	{
+		return id < m_first ? builtin_name(id) : m_names[id - m_first];
+	}
+	size_t size() const
+	{
+		return m_first + m_names.size();
+	}
+	static name_table& instance();
+};
+
+inline atom intern(string_view name)
+{
+	return name_table::instance().intern(name);
+}
+
+inline string_view atom_name(atom id)
+{
+	return name_table::instance().name(id);
+}
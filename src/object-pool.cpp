@@ -0,0 +1,280 @@
+/*
+//  Copyright (c) 2020 Peter Frane Jr. All Rights Reserved.
+//
+//  Use of this source code is governed by the GPL v. 3.0 license that can be
+//  found in the LICENSE file.
+//
+//  This software is distributed on an "AS IS" basis, WITHOUT WARRANTY
+//  OF ANY KIND, either express or implied.
+//
+//  For inquiries, email the author at pfranejr AT hotmail.com
+*/
+
+#include "object-pool.h"
+#include <new>
+#include <stdlib.h>
+
+// the pool of the processor running on this thread (see object_pool::scope); objects
+// allocated outside any scope come from the heap
+static thread_local object_pool* current_pool = nullptr;
+
+object_pool::object_pool() : m_slabs()
+{
+}
+
+object_pool::~object_pool()
+{
+	destroy_live();
+
+	for (slab& s : m_slabs)
+	{
+		free(s.m_data);
+	}
+}
+
+object_pool::scope::scope(object_pool& pool) : m_previous(current_pool)
+{
+	current_pool = &pool;
+}
+
+object_pool::scope::~scope()
+{
+	current_pool = m_previous;
+}
+
+// the blocks still allocated, found by walking the slabs: all are detached
+// before any is destroyed, and all are destroyed before any is freed, since
+// destroying one may still touch the others
+
+void object_pool::destroy_live()
+{
+	vector<void*> live;
+
+	if (!m_detach || !m_destroy)
+	{
+		return;
+	}
+	if (!m_slabs.empty())
+	{
+		m_slabs.back().m_used = m_cursor - m_slabs.back().m_data;
+	}
+
+	for (slab& s : m_slabs)
+	{
+		size_t offset = 0;
+
+		while (offset < s.m_used)
+		{
+			block_header* header = (block_header*)(s.m_data + offset);
+
+			if (bs_live == header->m_state)
+			{
+				live.push_back(header + 1);
+			}
+
+			offset += header->m_size;
+		}
+	}
+	for (large_block* block = m_large; block; block = block->m_next)
+	{
+		live.push_back((block_header*)(block + 1) + 1);
+	}
+
+	for (void* ptr : live)
+	{
+		m_detach(ptr);
+	}
+	for (void* ptr : live)
+	{
+		m_destroy(ptr);
+	}
+	for (void* ptr : live)
+	{
+		deallocate(ptr);
+	}
+}
+
+void* object_pool::carve(size_t size_class)
+{
+	size_t size = (size_class + 1) * POOL_GRANULE + sizeof(block_header);
+	block_header* header = (block_header*)bump(size);
+
+	header->m_size = (uint32_t)size;
+
+	return header;
+}
+
+void* object_pool::allocate_permanent(size_t size)
+{
+	block_header* header;
+
+	size = ((size + POOL_GRANULE - 1) & ~(size_t)(POOL_GRANULE - 1)) + sizeof(block_header);
+
+	if (size > POOL_SLAB_SIZE)
+	{
+		throw bad_alloc();
+	}
+
+	header = (block_header*)bump(size);
+
+	header->m_owner = this;
+	header->m_size = (uint32_t)size;
+	header->m_size_class = 0;
+	header->m_state = bs_permanent;
+
+	++m_stats.m_permanent;
+
+	return header + 1;
+}
+
+void* object_pool::bump(size_t size)
+{
+	char* block;
+
+	if ((size_t)(m_limit - m_cursor) < size)
+	{
+		char* data = (char*)malloc(POOL_SLAB_SIZE);
+
+		if (!data)
+		{
+			throw bad_alloc();
+		}
+		if (!m_slabs.empty())
+		{
+			m_slabs.back().m_used = m_cursor - m_slabs.back().m_data;
+		}
+
+		m_slabs.push_back({ data, 0 });
+
+		m_cursor = data;
+		m_limit = data + POOL_SLAB_SIZE;
+
+		++m_stats.m_slabs;
+	}
+
+	block = m_cursor;
+
+	m_cursor += size;
+
+	return block;
+}
+
+void* object_pool::allocate(size_t size)
+{
+	object_pool* pool = current_pool;
+	size_t size_class = (size + POOL_GRANULE - 1) / POOL_GRANULE - 1;
+	block_header* header;
+
+	if (!pool)
+	{
+		header = (block_header*)malloc(size + sizeof(block_header));
+
+		if (!header)
+		{
+			throw bad_alloc();
+		}
+
+		header->m_owner = nullptr;
+	}
+	else if (size_class >= POOL_SIZE_CLASSES)
+	{
+		// from the heap, but listed so the pool can destroy it
+		large_block* block = (large_block*)malloc(sizeof(large_block) + sizeof(block_header) + size);
+
+		if (!block)
+		{
+			throw bad_alloc();
+		}
+
+		block->m_previous = nullptr;
+		block->m_next = pool->m_large;
+
+		if (pool->m_large)
+		{
+			pool->m_large->m_previous = block;
+		}
+
+		pool->m_large = block;
+
+		header = (block_header*)(block + 1);
+
+		header->m_owner = pool;
+		header->m_state = bs_large;
+
+		++pool->m_stats.m_allocations;
+		++pool->m_stats.m_large;
+		++pool->m_stats.m_live;
+	}
+	else
+	{
+		free_block* block = pool->m_free[size_class];
+
+		if (block)
+		{
+			pool->m_free[size_class] = block->m_next;
+
+			header = (block_header*)block - 1;
+
+			++pool->m_stats.m_hits;
+		}
+		else
+		{
+			header = (block_header*)pool->carve(size_class);
+		}
+
+		header->m_owner = pool;
+		header->m_size_class = (uint16_t)size_class;
+		header->m_state = bs_live;
+
+		++pool->m_stats.m_allocations;
+		++pool->m_stats.m_live;
+	}
+
+	return header + 1;
+}
+
+void object_pool::deallocate(void* ptr)
+{
+	block_header* header = (block_header*)ptr - 1;
+	object_pool* pool = header->m_owner;
+
+	if (!pool)
+	{
+		free(header);
+	}
+	else if (bs_large == header->m_state)
+	{
+		large_block* block = (large_block*)header - 1;
+
+		if (block->m_previous)
+		{
+			block->m_previous->m_next = block->m_next;
+		}
+		else
+		{
+			pool->m_large = block->m_next;
+		}
+		if (block->m_next)
+		{
+			block->m_next->m_previous = block->m_previous;
+		}
+
+		free(block);
+
+		++pool->m_stats.m_frees;
+		--pool->m_stats.m_live;
+	}
+	else
+	{
+		free_block* block = (free_block*)ptr;
+
+		block->m_next = pool->m_free[header->m_size_class];
+
+		pool->m_free[header->m_size_class] = block;
+
+		header->m_state = bs_free;
+
+		++pool->m_stats.m_frees;
+		--pool->m_stats.m_live;
+	}
+}
@@ -0,0 +1,125 @@
+/*
+//  Copyright (c) 2020 Peter Frane Jr. All Rights Reserved.
+//
+//  Use of this source code is governed by the GPL v. 3.0 license that can be
+//  found in the LICENSE file.
+//
+//  This software is distributed on an "AS IS" basis, WITHOUT WARRANTY
+//  OF ANY KIND, either express or implied.
+//
+//  For inquiries, email the author at pfranejr AT hotmail.com
+*/
+
+#pragma once
+#include <vector>
+#include <inttypes.h>
+#include <stddef.h>
+
+using namespace std;
+
+#define POOL_GRANULE 16
+#define POOL_SIZE_CLASSES 32 // blocks of up to POOL_GRANULE * POOL_SIZE_CLASSES bytes
+#define POOL_SLAB_SIZE 65536
+
+struct pool_stats
+{
+	uint64_t m_allocations{ 0 };
+	uint64_t m_frees{ 0 };
+	uint64_t m_hits{ 0 }; // allocations served from a free list
+	uint64_t m_large{ 0 }; // allocations too large for the pool, left to the heap
+	uint64_t m_slabs{ 0 };
+	uint64_t m_live{ 0 };
+	uint64_t m_permanent{ 0 }; // objects in the arena (see allocate_permanent)
+	double hit_rate() const
+	{
+		return m_allocations ? (double)m_hits / (double)m_allocations : 0.0;
+	}
+};
+
+// Size-class allocator for the composite objects (strings, arrays, dictionaries,
+// fonts) of one processor. Blocks are carved from 64K slabs and recycled through a
+// free list per size class; all the slabs are released at once when the pool is
+// destroyed. Objects still alive then, such as reference cycles, are destroyed
+// first through the teardown functions (see set_teardown), so their own storage
+// is freed too. Composite objects are allocated from the current pool of the
+// thread (see composite_object::operator new and object_pool::scope), so they
+// must not outlive it
+
+class object_pool
+{
+	enum block_state : uint8_t
+	{
+		bs_free,
+		bs_live,
+		bs_large, // from the heap, in the list of large blocks
+		bs_permanent
+	};
+	struct alignas(POOL_GRANULE) block_header
+	{
+		object_pool* m_owner; // null for heap blocks
+		uint32_t m_size; // of the whole block, header included, to walk the slabs
+		uint16_t m_size_class;
+		block_state m_state;
+	};
+	struct alignas(POOL_GRANULE) large_block
+	{
+		large_block* m_previous;
+		large_block* m_next;
+	};
+	struct free_block
+	{
+		free_block* m_next;
+	};
+	struct slab
+	{
+		char* m_data;
+		size_t m_used;
+	};
+	vector<slab> m_slabs;
+	char* m_cursor{ nullptr };
+	char* m_limit{ nullptr };
+	free_block* m_free[POOL_SIZE_CLASSES]{ nullptr };
+	large_block* m_large{ nullptr }; // live blocks too large for the slabs
+	pool_stats m_stats;
+	void (*m_detach)(void*) { nullptr };
+	void (*m_destroy)(void*) { nullptr };
+
+	static_assert(sizeof(block_header) == POOL_GRANULE, "The block header must keep the objects aligned");
+
+	void* carve(size_t size_class);
+	void* bump(size_t size);
+	void destroy_live();
+public:
+	object_pool();
+	~object_pool();
+	object_pool(const object_pool&) = delete;
+	object_pool& operator=(const object_pool&) = delete;
+	const pool_stats& stats() const
+	{
+		return m_stats;
+	}
+	static void* allocate(size_t size);
+	static void deallocate(void* ptr);
+	// memory that is never freed on its own, only with the pool
+	void* allocate_permanent(size_t size);
+	// how the blocks still allocated are destroyed with the pool: 'detach' is
+	// called on each of them first, so that destroying one doesn't free another,
+	// then 'destroy'. Permanent blocks are left to their owner
+	void set_teardown(void (*detach)(void*), void (*destroy)(void*))
+	{
+		m_detach = detach;
+		m_destroy = destroy;
+	}
+	// makes a pool the current one of the thread while it lives. The owner of the
+	// pool opens one around its work, so that with several owners on a thread each
+	// allocates from its own pool; scopes nest
+	class scope
+	{
+		object_pool* m_previous;
+	public:
+		explicit scope(object_pool& pool);
+		~scope();
+		scope(const scope&) = delete;
+		scope& operator=(const scope&) = delete;
+	};
+};
@@ -0,0 +1,147 @@
+/*
+//  Copyright (c) 2020 Peter Frane Jr. All Rights Reserved.
+//
+//  Use of this source code is governed by the GPL v. 3.0 license that can be
+//  found in the LICENSE file.
+//
+//  This software is distributed on an "AS IS" basis, WITHOUT WARRANTY
+//  OF ANY KIND, either express or implied.
+//
+//  For inquiries, email the author at pfranejr AT hotmail.com
+*/
+
+#pragma once
+#include "data.h"
+#include <vector>
+#include <algorithm>
+
+// enough for an array of MAX_OBJECT_SIZE elements built with [ ]
+#define MAX_OPERAND_STACK_SIZE (MAX_OBJECT_SIZE * 2)
+
+// The operand stack: one array with the top at the end, allocated up to the
+// limit at once, so a push never moves the operands and references to them
+// stay valid. Operands are indexed from the top: stack[0] is the top one
+
+class operand_stack
+{
+	vector<operand> m_data;
+	size_t m_limit{ MAX_OPERAND_STACK_SIZE };
+public:
+	operand_stack() : m_data()
+	{
+		m_data.reserve(m_limit);
+	}
+	operand& operator[](size_t index)
+	{
+		return m_data[m_data.size() - 1 - index];
+	}
+	const operand& operator[](size_t index) const
+	{
+		return m_data[m_data.size() - 1 - index];
+	}
+	size_t size() const
+	{
+		return m_data.size();
+	}
+	bool empty() const
+	{
+		return m_data.empty();
+	}
+	size_t limit() const
+	{
+		return m_limit;
+	}
+	void set_limit(size_t limit)
+	{
+		if (limit < m_data.size())
+		{
+			throw runtime_error("The operand stack is larger than the new limit");
+		}
+
+		m_limit = limit;
+
+		m_data.reserve(m_limit);
+	}
+	void push(const operand& op)
+	{
+		if (m_data.size() >= m_limit)
+		{
+			throw runtime_error("Stack overflow");
+		}
+		m_data.push_back(op);
+	}
+	void push(operand&& op)
+	{
+		if (m_data.size() >= m_limit)
+		{
+			throw runtime_error("Stack overflow");
+		}
+		m_data.push_back(std::move(op));
+	}
+	// removes the top operand and returns it; the caller checks the size
+	operand take()
+	{
+		operand op(std::move(m_data.back()));
+
+		m_data.pop_back();
+
+		return op;
+	}
+	// the caller checks the size
+	void pop(size_t count)
+	{
+		m_data.erase(m_data.end() - count, m_data.end());
+	}
+	void clear()
+	{
+		m_data.clear();
+	}
+	// pushes copies of the top 'count' operands
+	void copy(size_t count)
+	{
+		size_t first = m_data.size() - count;
+
+		if (m_data.size() + count > m_limit)
+		{
+			throw runtime_error("Stack overflow in --copy--");
+		}
+		for (size_t i = 0; i < count; ++i)
+		{
+			m_data.push_back(m_data[first + i]);
+		}
+	}
+	// rolls the top 'count' operands up by 'times' positions; negative rolls down
+	void roll(size_t count, int32_t times)
+	{
+		size_t shift;
+
+		if (0 == count)
+		{
+			return;
+		}
+
+		shift = (size_t)(((int64_t)times % (int64_t)count + (int64_t)count) % (int64_t)count);
+
+		if (shift > 0)
+		{
+			std::rotate(m_data.end() - count, m_data.end() - shift, m_data.end());
+		}
+	}
+	// from the top down
+	vector<operand>::reverse_iterator begin()
+	{
+		return m_data.rbegin();
+	}
+	vector<operand>::reverse_iterator end()
+	{
+		return m_data.rend();
+	}
+	vector<operand>::const_reverse_iterator begin() const
+	{
+		return m_data.rbegin();
+	}
+	vector<operand>::const_reverse_iterator end() const
+	{
+		return m_data.rend();
+	}
+};
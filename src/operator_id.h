@@ -72,6 +72,7 @@ enum operator_id
 	op_id_exp,
 	op_id_false,
 	op_id_fill,
+	op_id_filter,
 	op_id_findfont,
 	op_id_flattenpath,
 	op_id_floor,
@@ -13,7 +13,7 @@
 
 #include "processor.h"
 
-void processor::do_path_ops(operator_handler* handler)
+void processor::do_path_ops(const operator_handler* handler)
 {
 	size_t param_count = handler->m_param_count;
 	double v[6]{ 0.0 };
@@ -180,7 +180,7 @@ void processor::do_path_ops(operator_handler* handler)
 	}
 }
 
-void processor::do_flattenpath(operator_handler* handler)
+void processor::do_flattenpath(const operator_handler* handler)
 {
 	if (has_current_point())
 	{
@@ -222,7 +222,7 @@ error_msg:
 	message("Internal error in --%s--. The graphics backend is in an unknown error state", handler->m_name);
 }
 
-void processor::do_clippath(operator_handler* handler)
+void processor::do_clippath(const operator_handler* handler)
 {
 	if (cairo_has_current_point(m_cairo) == 0)
 	{
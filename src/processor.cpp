@@ -26,11 +26,29 @@ void processor::read_dsc(const string& str)
 	const char b[] = { "BoundingBox:" };
 	size_t len = sizeof(b) - 1;
 
-	if (str.compare(0, len, b) == 0)
+	if (str.compare(0, 9, "EndProlog") == 0 || str.compare(0, 5, "Page:") == 0)
 	{
+		m_in_prolog = false;
+	}
+	else if (str.compare(0, len, b) == 0)
+	{
+		const dsc_index& dsc = m_scanner.dsc();
 		const char* values = str.c_str() + len;
 		int dim[4]{ 0 };
 
+		// already known from the pre-scan of the input, including '(atend)'
+		if (dsc.m_has_bounding_box)
+		{
+			if (dsc.width() > 0 && dsc.height() > 0)
+			{
+				m_bounding_box.m_col = dsc.m_bounding_box[0];
+				m_bounding_box.m_row = dsc.m_bounding_box[1];
+				m_bounding_box.m_width = dsc.width();
+				m_bounding_box.m_height = dsc.height();
+			}
+			return;
+		}
+
 		//todo: check the range
 		if (sscanf_s(values, "%d %d %d %d", &dim[0], &dim[1], &dim[2], &dim[3]) == 4)
 		{
@@ -62,6 +80,8 @@ void processor::read_dsc(const string& str)
 
 bool processor::process_token(const token& tkn)
 {
+	object_pool::scope scope(m_pool);
+
 	try
 	{
 		switch (tkn.m_type)
@@ -82,7 +102,7 @@ bool processor::process_token(const token& tkn)
 			break;
 		case ot_constant:
 		case ot_name:
-			do_name(tkn.m_name, tkn.m_type);
+			do_name(intern(tkn.m_view), tkn.m_type);
 			break;
 		case ot_dictionary_marker_off:
 			if (in_procedure())
@@ -113,10 +133,10 @@ bool processor::process_token(const token& tkn)
 			//break;
 		case ot_hex_string:
 		case ot_text_string:
-			push_string(tkn.m_string, tkn.m_type);
+			push_string(tkn.m_view, tkn.m_type);
 			break;
 		case ot_literal:
-			push_name(tkn.m_name, -1, tkn.m_type);
+			push_name(intern(tkn.m_view), tkn.m_type);
 			break;
 		}
 
@@ -136,7 +156,7 @@ bool processor::process_token(const token& tkn)
 	}
 }
 
-void processor::do_quit(operator_handler* handler)
+void processor::do_quit(const operator_handler* handler)
 {
 	m_quit = true;
 }
@@ -13,6 +13,7 @@
 
 #pragma once
 #include "scanner.h"
+#include "operand-stack.h"
 #include <deque>
 #include <vector>
 #include <cairo.h>
@@ -94,11 +95,20 @@ struct gstate
 };
 
 
-#define MAX_OPERAND_STACK_SIZE 500
+// how often compiled procedures found the lookup of a name in their cache
+struct name_cache_stats
+{
+	uint64_t m_hits{ 0 };
+	uint64_t m_misses{ 0 };
+};
 
 class processor : public common_class
 {
-	deque<operand> m_operand_stack;
+	object_pool m_pool; // first, so that it is destroyed after the objects of the other members
+	vector<composite_object*> m_arena; // procedure bodies of the prolog, destroyed with the processor
+	bool m_in_prolog{ true }; // until %%EndProlog or the first %%Page; the whole input if there is neither
+	int m_nested_input{ 0 }; // running tokens of a filter (exec) or read with 'token', not the main input
+	operand_stack m_operand_stack;
 	dictionary_container *m_dictionary;
 	scanner& m_scanner;
 	int m_procedure_counter{ 0 };
@@ -107,6 +117,7 @@ class processor : public common_class
 	rectangle m_bounding_box;
 	uint32_t m_rand{ 1 };
 	vector<gstate *> m_path_list;
+	vector<scanner*> m_filter_list;
 	cairo_matrix_t m_ctm{0};
 	bool m_has_current_point{ false };
 	double m_scale{ 96.0/ 72.0 };
@@ -117,6 +128,7 @@ class processor : public common_class
 	alloc_type m_alloc_type{ at_local };
 	point m_current_point, m_last_moveto;
 	color m_color;
+	name_cache_stats m_name_cache;
 
 	bool in_procedure()const
 	{
@@ -138,6 +150,11 @@ class processor : public common_class
 			delete p;
 		}
 		m_path_list.clear();
+		for (auto* p : m_filter_list)
+		{
+			delete p;
+		}
+		m_filter_list.clear();
 	}
 	size_t stack_size() const
 	{
@@ -147,21 +164,36 @@ class processor : public common_class
 	{
 		return m_has_current_point;
 	}
+	// an object that lives until the end of the job, in one block with the others
+	template<typename T, typename... Args>
+	T* create_permanent(Args... args)
+	{
+		T* obj = ::new (m_pool.allocate_permanent(sizeof(T))) T(args...);
+
+		obj->set_permanent();
+
+		m_arena.push_back(obj);
+
+		return obj;
+	}
 	void push_number(double number, operand_type type);
 	void push_operand(operand& op);
+	void push_operand(operand&& op);
+	operand pop_operand();
 	void push_type(operand_type type);
-	void push_name(const char *name, int32_t len, operand_type type);
-	void push_string(const string &str, operand_type type);
-	void do_name(const char* name, operand_type type);
+	void push_name(atom name, operand_type type);
+	void push_string(string_view str, operand_type type);
+	void do_name(atom name, operand_type type);
 	void create_array(operand_type type);
 	void create_dictionary();
 	int32_t counttomark();
 	void pop();
 	void pop(size_t count);
-	operator_handler *search_operator_dictionary(const char* name);
-	bool search_system_dictionary(const char* name, operand &value);
-	void execute_operator(operator_handler* handler);
+	bool search_system_dictionary(atom name, operand &value);
+	void execute_operator(const operator_handler* handler);
 	void execute_procedure(operand &op);
+	void execute_item(operand& item);
+	void execute_name(instruction& code);
 	void read_dsc(const string& str);
 	void do_dictionary_begin(operand& op);
 	void do_dictionary_end();
@@ -170,13 +202,16 @@ class processor : public common_class
 	
 	size_t get_transform_params(double& x, double& y, double* values, bool pop_params);
 public:
-	processor(scanner& _scanner) : common_class(), m_scanner(_scanner),	
-		m_operand_stack(), m_dictionary(), m_path_list()
+	processor(scanner& _scanner) : common_class(), m_pool(), m_arena(), m_scanner(_scanner),	
+		m_operand_stack(), m_dictionary(), m_path_list(), m_filter_list()
 	{
+		object_pool::scope scope(m_pool);
 		cairo_matrix_t tmp = { m_scale, 0, 0, m_scale, 0, 0 };
 
 		m_ctm = tmp;
 
+		m_pool.set_teardown(&composite_object::detach, &composite_object::destroy);
+
 		m_dictionary = new dictionary_container;
 
 		if (!m_dictionary)
@@ -187,12 +222,18 @@ public:
 	}
 	~processor()
 	{
+		object_pool::scope scope(m_pool);
+
 		clear();
 				
 		if (m_dictionary)
 		{
 			delete m_dictionary;
 		}
+		for (auto* obj : m_arena)
+		{
+			obj->~composite_object();
+		}
 		{
 			if (m_cairo)
 			{
@@ -204,6 +245,20 @@ public:
 			}
 		}
 	}	
+	// allocation counts of the composite objects of this processor
+	const pool_stats& object_stats() const
+	{
+		return m_pool.stats();
+	}
+	const name_cache_stats& name_cache() const
+	{
+		return m_name_cache;
+	}
+	// the most operands the stack may hold (MAX_OPERAND_STACK_SIZE by default)
+	void set_stack_limit(size_t limit)
+	{
+		m_operand_stack.set_limit(limit);
+	}
 	void clear_error()
 	{
 		common_class::clear();
@@ -219,90 +274,92 @@ public:
 	int32_t operator_dictionary_size();
 	bool process_token(const token& tkn);
 	void dump_stack();
-	bool find_key(const char* name, operand& value);
+	bool find_key(atom name, operand& value);
 	bool find_key(const operand& key, operand& value);
-	void do_dictionary_ops(operator_handler* handler);
-	void do_def(operator_handler* handler);
+	void do_dictionary_ops(const operator_handler* handler);
+	void do_def(const operator_handler* handler);
 	void do_bind(operand &op);
-	void do_pop(operator_handler* handler);
-	void do_pstack(operator_handler* handler);
-	void do_print_n_pop(operator_handler* handler);
-	void do_copy(operator_handler* handler);
+	void do_pop(const operator_handler* handler);
+	void do_pstack(const operator_handler* handler);
+	void do_print_n_pop(const operator_handler* handler);
+	void do_copy(const operator_handler* handler);
 	void do_exch();
-	void do_stack_ops(operator_handler* handler);
-	void do_math_binary_ops(operator_handler* handler);
-	void do_math_unary_ops(operator_handler* handler);
-	void do_math_misc_ops(operator_handler* handler);
-	void do_path_ops(operator_handler* handler);
-	void do_clippath(operator_handler* handler);
-	void do_roll(operator_handler* handler);
-	void do_eq(operator_handler* handler);
-	void do_ne(operator_handler* handler);
-	void do_lt(operator_handler* handler);
-	void do_le(operator_handler* handler);
-	void do_gt(operator_handler* handler);
-	void do_ge(operator_handler* handler);
-	void do_true(operator_handler* handler);
-	void do_false(operator_handler* handler);
-	void do_if(operator_handler* handler);
-	void do_ifelse(operator_handler* handler);
-	void do_where(operator_handler* handler);
-	void do_get(operator_handler* handler);
-	void do_setrgbcolor(operator_handler* handler);
-	void do_setlinejoin(operator_handler* handler);
-	void do_setlinecap(operator_handler* handler);
-	void do_gsave(operator_handler* handler);
-	void do_grestore(operator_handler* handler);
-	void do_set_graphics_state(operator_handler* handler);
-	void do_get_graphics_state(operator_handler* handler);
-	void do_matrix(operator_handler* handler);
-	void do_rotate(operator_handler* handler);
-	void do_scale(operator_handler* handler);
-	void do_translate(operator_handler* handler);
-	void do_invertmatrix(operator_handler* handler);
-	void do_concatmatrix(operator_handler* handler);
-	void do_setdash(operator_handler* handler);
-	void do_setcmykcolor(operator_handler* handler);
-	void do_currentrgbcolor(operator_handler* handler);
-	void do_currentcmykcolor(operator_handler* handler);
-	void do_currentgray(operator_handler* handler);
+	void do_stack_ops(const operator_handler* handler);
+	void do_math_binary_ops(const operator_handler* handler);
+	void do_math_unary_ops(const operator_handler* handler);
+	void do_math_misc_ops(const operator_handler* handler);
+	void do_path_ops(const operator_handler* handler);
+	void do_clippath(const operator_handler* handler);
+	void do_roll(const operator_handler* handler);
+	void do_eq(const operator_handler* handler);
+	void do_ne(const operator_handler* handler);
+	void do_lt(const operator_handler* handler);
+	void do_le(const operator_handler* handler);
+	void do_gt(const operator_handler* handler);
+	void do_ge(const operator_handler* handler);
+	void do_true(const operator_handler* handler);
+	void do_false(const operator_handler* handler);
+	void do_if(const operator_handler* handler);
+	void do_ifelse(const operator_handler* handler);
+	void do_where(const operator_handler* handler);
+	void do_get(const operator_handler* handler);
+	void do_setrgbcolor(const operator_handler* handler);
+	void do_setlinejoin(const operator_handler* handler);
+	void do_setlinecap(const operator_handler* handler);
+	void do_gsave(const operator_handler* handler);
+	void do_grestore(const operator_handler* handler);
+	void do_set_graphics_state(const operator_handler* handler);
+	void do_get_graphics_state(const operator_handler* handler);
+	void do_matrix(const operator_handler* handler);
+	void do_rotate(const operator_handler* handler);
+	void do_scale(const operator_handler* handler);
+	void do_translate(const operator_handler* handler);
+	void do_invertmatrix(const operator_handler* handler);
+	void do_concatmatrix(const operator_handler* handler);
+	void do_setdash(const operator_handler* handler);
+	void do_setcmykcolor(const operator_handler* handler);
+	void do_currentrgbcolor(const operator_handler* handler);
+	void do_currentcmykcolor(const operator_handler* handler);
+	void do_currentgray(const operator_handler* handler);
 	
-	void do_matrix_transform(operator_handler* handler);
-	void do_showpage(operator_handler* handler);
-	void do_repeat(operator_handler* handler);
-	void do_for(operator_handler* handler);
-	void do_findfont(operator_handler* handler);
-	void do_scalefont(operator_handler* handler);
-	void do_setfont(operator_handler* handler);
-	void do_selectfont(operator_handler* handler);
-	void do_show(operator_handler* handler);
-	void do_charpath(operator_handler* handler);
-	void do_string(operator_handler* handler);
-	void do_stringwidth(operator_handler* handler);
-	void do_put(operator_handler* handler);
-	void do_flattenpath(operator_handler* handler);
-	void do_cvs(operator_handler* handler);
-	void do_cvx(operator_handler* handler);
-	void do_aload(operator_handler* handler);
-	void do_quit(operator_handler* handler);
-	void do_length(operator_handler* handler);
-	void do_save(operator_handler* handler);
-	void do_restore(operator_handler* handler);
-	void do_print_top_stack(operator_handler* handler);
-	void do_stack(operator_handler* handler);
-	void do_misc_ops(operator_handler* handler);
-	void do_logic_misc_ops(operator_handler* handler);
-	void do_array(operator_handler* handler);
-	void do_astore(operator_handler* handler);
-	void do_setglobal(operator_handler* handler);
-	void do_replace_matrix(operator_handler* handler);
-	void do_initmatrix(operator_handler* handler);
-	void do_setmatrix(operator_handler* handler);
-	void do_concat(operator_handler* handler);
-	void do_setpagedevice(operator_handler* handler);
-	void do_exec(operator_handler* handler);
-	void do_currentfile(operator_handler* handler);
-	void do_token(operator_handler* handler);
+	void do_matrix_transform(const operator_handler* handler);
+	void do_showpage(const operator_handler* handler);
+	void do_repeat(const operator_handler* handler);
+	void do_for(const operator_handler* handler);
+	void do_findfont(const operator_handler* handler);
+	void do_scalefont(const operator_handler* handler);
+	void do_setfont(const operator_handler* handler);
+	void do_selectfont(const operator_handler* handler);
+	void do_show(const operator_handler* handler);
+	void do_charpath(const operator_handler* handler);
+	void do_string(const operator_handler* handler);
+	void do_stringwidth(const operator_handler* handler);
+	void do_put(const operator_handler* handler);
+	void do_flattenpath(const operator_handler* handler);
+	void do_cvs(const operator_handler* handler);
+	void do_cvx(const operator_handler* handler);
+	void do_aload(const operator_handler* handler);
+	void do_quit(const operator_handler* handler);
+	void do_length(const operator_handler* handler);
+	void do_save(const operator_handler* handler);
+	void do_restore(const operator_handler* handler);
+	void do_print_top_stack(const operator_handler* handler);
+	void do_stack(const operator_handler* handler);
+	void do_misc_ops(const operator_handler* handler);
+	void do_logic_misc_ops(const operator_handler* handler);
+	void do_array(const operator_handler* handler);
+	void do_astore(const operator_handler* handler);
+	void do_setglobal(const operator_handler* handler);
+	void do_replace_matrix(const operator_handler* handler);
+	void do_initmatrix(const operator_handler* handler);
+	void do_setmatrix(const operator_handler* handler);
+	void do_concat(const operator_handler* handler);
+	void do_setpagedevice(const operator_handler* handler);
+	void do_exec(const operator_handler* handler);
+	void do_currentfile(const operator_handler* handler);
+	void do_token(const operator_handler* handler);
+	void do_filter(const operator_handler* handler);
+	void execute_file(scanner* scr);
 };
 
 struct system_dictionary : public base_dictionary
@@ -314,11 +371,11 @@ struct system_dictionary : public base_dictionary
 	~system_dictionary()
 	{
 	}
-	void put(const operand& key, const operand& value)
+	void put(const operand& key, operand value)
 	{
 		throw runtime_error("Write error in --put--");
 	}
-	bool find(const char* name, operand &value)
+	bool find(atom name, operand &value)
 	{
 		return m_processor->find_key(name, value);
 	}	
@@ -349,12 +406,18 @@ struct system_dictionary : public base_dictionary
 	{
 		addref();
 	}
-	bool key_exists(const char* name)
+	bool key_exists(atom name)
 	{
 		operand tmp;
 
 		return m_processor->find_key(name, tmp);
 	}
+	bool lookup(atom name, operand*& value)
+	{
+		value = nullptr;
+
+		return key_exists(name);
+	}
 	bool key_exists(const operand& key)
 	{
 		operand tmp;
@@ -0,0 +1,292 @@
+/*
+//  Copyright (c) 2020 Peter Frane Jr. All Rights Reserved.
+//
+//  Use of this source code is governed by the GPL v. 3.0 license that can be
+//  found in the LICENSE file.
+//
+//  This software is distributed on an "AS IS" basis, WITHOUT WARRANTY
+//  OF ANY KIND, either express or implied.
+//
+//  For inquiries, email the author at pfranejr AT hotmail.com
+*/
+
+#include "read-ahead.h"
+#include <string.h>
+#include <errno.h>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#include <windows.h>
+#include <chrono>
+#else
+#include <unistd.h>
+#include <poll.h>
+#endif
+
+read_ahead::read_ahead(FILE* file) : m_file(file), m_thread()
+{
+#ifdef _WIN32
+	if (stdin == file)
+	{
+		_setmode(_fileno(stdin), _O_BINARY);
+	}
+#endif
+	for (auto& b : m_blocks)
+	{
+		b.m_data.resize(READ_AHEAD_BLOCK_SIZE);
+	}
+#ifndef _WIN32
+	if (pipe(m_wakeup) != 0)
+	{
+		m_wakeup[0] = m_wakeup[1] = -1;
+	}
+#endif
+
+	m_thread = thread(&read_ahead::run, this);
+}
+
+read_ahead::~read_ahead()
+{
+	// the reader may be blocked on a pipe whose writer is still open, e.g. when the
+	// program quits early; it is woken up rather than waited for
+	{
+		lock_guard<mutex> lock(m_mutex);
+
+		m_stop = true;
+	}
+
+	m_changed.notify_all();
+
+#ifdef _WIN32
+	{
+		unique_lock<mutex> lock(m_mutex);
+
+		// only a read in progress can be cancelled; retry until the reader ends
+		while (!m_done)
+		{
+			CancelSynchronousIo((HANDLE)m_thread.native_handle());
+
+			m_changed.wait_for(lock, chrono::milliseconds(10));
+		}
+	}
+#else
+	if (m_wakeup[1] >= 0 && write(m_wakeup[1], "", 1) < 0)
+	{
+		// the reader ends with its current read
+	}
+#endif
+
+	if (m_thread.joinable())
+	{
+		m_thread.join();
+	}
+#ifndef _WIN32
+	for (int fd : m_wakeup)
+	{
+		if (fd >= 0)
+		{
+			close(fd);
+		}
+	}
+#endif
+	if (m_file && m_file != stdin)
+	{
+		fclose(m_file);
+	}
+}
+
+// unlike fread(), returns as soon as the pipe has data; 'count' is 0 at the end
+// of the input, or when the destructor wakes the reader up. Reads interrupted by
+// a signal are retried
+bool read_ahead::read_some(char* buf, size_t len, size_t& count)
+{
+	for (;;)
+	{
+#ifdef _WIN32
+		int result = _read(_fileno(m_file), buf, (unsigned int)len);
+#else
+		ssize_t result;
+
+		if (m_wakeup[0] >= 0)
+		{
+			pollfd fds[2] = { { fileno(m_file), POLLIN, 0 }, { m_wakeup[0], POLLIN, 0 } };
+
+			if (poll(fds, 2, -1) < 0)
+			{
+				if (EINTR == errno)
+				{
+					continue;
+				}
+				return false;
+			}
+			if (fds[1].revents != 0)
+			{
+				count = 0;
+
+				return true;
+			}
+		}
+
+		result = ::read(fileno(m_file), buf, len);
+#endif
+
+		if (result >= 0)
+		{
+			count = (size_t)result;
+
+			return true;
+		}
+		else if (errno != EINTR)
+		{
+			return false;
+		}
+	}
+}
+
+void read_ahead::run()
+{
+	size_t index = 0;
+	size_t carry = 0; // length of an incomplete last line, kept for the next block
+	bool eof = false;
+
+	while (!eof && !m_stop)
+	{
+		block& b = m_blocks[index];
+		block& other = m_blocks[index ^ 1];
+		size_t size = 0, cut = 0;
+
+		{
+			unique_lock<mutex> lock(m_mutex);
+
+			m_changed.wait(lock, [&] { return !b.m_full || m_stop; });
+
+			if (m_stop)
+			{
+				break;
+			}
+		}
+
+		if (carry > 0)
+		{
+			// the tail of the other block; it is still ours to read since it wasn't handed over
+			memcpy(b.m_data.data(), other.m_data.data() + other.m_size, carry);
+
+			size = carry;
+			carry = 0;
+		}
+
+		// fill until a line break arrives, the block is full or the input ends
+		while (size < b.m_data.size())
+		{
+			size_t count;
+
+			if (!read_some(b.m_data.data() + size, b.m_data.size() - size, count))
+			{
+				// what was read so far is still handed over; the error follows it
+				lock_guard<mutex> lock(m_mutex);
+
+				m_error = errno;
+
+				eof = true;
+				break;
+			}
+			if (0 == count)
+			{
+				eof = true;
+				break;
+			}
+
+			size_t start = size;
+
+			size += count;
+
+			for (size_t i = size; i > start; --i)
+			{
+				if ('\n' == b.m_data[i - 1] || '\r' == b.m_data[i - 1])
+				{
+					cut = i;
+					break;
+				}
+			}
+			if (cut > 0)
+			{
+				break;
+			}
+		}
+
+		if (!eof && cut > 0 && cut < size)
+		{
+			carry = size - cut;
+			size = cut;
+		}
+
+		if (size > 0)
+		{
+			{
+				lock_guard<mutex> lock(m_mutex);
+
+				b.m_size = size;
+				b.m_full = true;
+			}
+
+			m_changed.notify_all();
+
+			index ^= 1;
+		}
+	}
+
+	{
+		lock_guard<mutex> lock(m_mutex);
+
+		m_done = true;
+	}
+
+	m_changed.notify_all();
+}
+
+bool read_ahead::next(const char*& data, size_t& size)
+{
+	unique_lock<mutex> lock(m_mutex);
+
+	if (m_holding)
+	{
+		m_blocks[m_consumer].m_full = false;
+		m_consumer ^= 1;
+		m_holding = false;
+
+		m_changed.notify_all();
+	}
+
+	block& b = m_blocks[m_consumer];
+
+	// the producer sets m_full before m_done
+	m_changed.wait(lock, [&] { return b.m_full || m_done; });
+
+	if (!b.m_full)
+	{
+		return false;
+	}
+
+	m_holding = true;
+
+	data = b.m_data.data();
+	size = b.m_size;
+
+	return true;
+}
+
+bool read_ahead::eof() const
+{
+	size_t next = m_holding ? (m_consumer ^ 1) : m_consumer;
+	lock_guard<mutex> lock(m_mutex);
+
+	return m_done && !m_blocks[next].m_full;
+}
+
+int read_ahead::error() const
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	return m_error;
+}
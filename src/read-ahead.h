@@ -0,0 +1,63 @@
+/*
+//  Copyright (c) 2020 Peter Frane Jr. All Rights Reserved.
+//
+//  Use of this source code is governed by the GPL v. 3.0 license that can be
+//  found in the LICENSE file.
+//
+//  This software is distributed on an "AS IS" basis, WITHOUT WARRANTY
+//  OF ANY KIND, either express or implied.
+//
+//  For inquiries, email the author at pfranejr AT hotmail.com
+*/
+
+#pragma once
+#include <stdio.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+#define READ_AHEAD_BLOCK_SIZE (1024 * 1024)
+
+// Reads a stream (stdin or a pipe) on a background thread while the scanner
+// consumes the previous block. The two blocks are handed over through a flag
+// each, under a mutex; either side sleeps on the condition variable while the
+// other has the block it needs (single producer, single consumer). A block ends
+// at a line break whenever possible, so the scanner sees whole lines as with fgets()
+
+class read_ahead
+{
+	struct block
+	{
+		vector<char> m_data;
+		size_t m_size{ 0 };
+		bool m_full{ false }; // owned by the consumer while set
+	};
+	FILE* m_file;
+	block m_blocks[2];
+	mutable mutex m_mutex; // guards m_full, m_done and m_error
+	condition_variable m_changed; // a block was filled or released, or the input ended
+	bool m_done{ false }; // no more blocks will be filled; the reader has ended
+	int m_error{ 0 }; // errno of the read that failed
+	atomic<bool> m_stop{ false };
+#ifndef _WIN32
+	int m_wakeup[2]{ -1, -1 }; // a pipe that wakes the reader up from a blocking read
+#endif
+	size_t m_consumer{ 0 }; // the block the consumer holds or waits for
+	bool m_holding{ false };
+	thread m_thread;
+	bool read_some(char* buf, size_t len, size_t& count);
+	void run();
+public:
+	read_ahead(FILE* file);
+	~read_ahead();
+	// releases the current block and waits for the next one; false at the end of the input
+	bool next(const char*& data, size_t& size);
+	// true if nothing follows the current block
+	bool eof() const;
+	// the errno of a failed read, once next() has returned false; 0 at the end of the input
+	int error() const;
+};
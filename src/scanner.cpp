@@ -12,6 +12,84 @@
 */
 
 #include "scanner.h"
+#include "filter.h"
+#include "inflate.h"
+#include "read-ahead.h"
+#include <cmath>
+
+// character classes used by the tokenizer; a character may belong to more than one
+
+enum char_class : uint8_t
+{
+	cc_regular = 0x01, // may appear in a name
+	cc_alpha = 0x02,
+	cc_digit = 0x04,
+	cc_hex_digit = 0x08,
+	cc_whitespace = 0x10,
+	cc_special = 0x20, // ( ) < > [ ] { } / %
+	cc_delimiter = cc_whitespace | cc_special
+};
+
+struct char_class_table
+{
+	uint8_t m_class[256];
+};
+
+static constexpr char_class_table make_char_class_table()
+{
+	char_class_table table{};
+	const char special[] = "()<>[]{}/%";
+	const char whitespace[] = { 0, '\t', '\n', '\f', '\r', ' ' };
+
+	for (int ch = '!'; ch <= '~'; ++ch)
+	{
+		table.m_class[ch] = cc_regular;
+	}
+	for (int ch = 'a'; ch <= 'z'; ++ch)
+	{
+		table.m_class[ch] |= cc_alpha;
+		table.m_class[ch - 'a' + 'A'] |= cc_alpha;
+	}
+	for (int ch = '0'; ch <= '9'; ++ch)
+	{
+		table.m_class[ch] |= cc_digit | cc_hex_digit;
+	}
+	for (int ch = 'a'; ch <= 'f'; ++ch)
+	{
+		table.m_class[ch] |= cc_hex_digit;
+		table.m_class[ch - 'a' + 'A'] |= cc_hex_digit;
+	}
+	for (size_t i = 0; i < sizeof(special) - 1; ++i)
+	{
+		table.m_class[(uint8_t)special[i]] = cc_special;
+	}
+	for (size_t i = 0; i < sizeof(whitespace); ++i)
+	{
+		table.m_class[(uint8_t)whitespace[i]] = cc_whitespace;
+	}
+
+	return table;
+}
+
+static constexpr char_class_table char_classes = make_char_class_table();
+
+static inline bool has_char_class(uint8_t ch, uint8_t mask)
+{
+	return (char_classes.m_class[ch] & mask) != 0;
+}
+
+scanner::~scanner()
+{
+	clear();
+
+	if (m_file && m_file != stdin)
+	{
+		fclose(m_file);
+	}
+
+	delete m_filter;
+	delete m_reader;
+}
 
 void scanner::clear()
 {
@@ -27,9 +105,53 @@ void scanner::get_error(int& column, int& row, string& msg)
 	msg = m_error;
 }
 
+void scanner::set_buffer(const char* start, size_t len)
+{
+	m_start = start;
+	m_curpos = start;
+	m_line = start;
+	m_endpos = start + len;
+}
+
 bool scanner::read_file()
 {
-	return fgets(m_buffer, MAX_LINE_BUF, m_file) != nullptr;
+	size_t len = 0;
+	int ch;
+
+	// one line at a time, like fgets(), but binary tokens may contain NUL
+	while (len < MAX_LINE_BUF && (ch = getc(m_file)) != EOF)
+	{
+		m_buffer[len++] = (char)ch;
+
+		if ('\n' == ch)
+		{
+			break;
+		}
+	}
+	if (MAX_LINE_BUF == len && m_buffer[len - 1] != '\n' && m_file != stdin)
+	{
+		// a longer line ends at its last white space, so that no number or name is
+		// cut; the rest is read again with the next line
+		size_t cut = len;
+
+		while (cut > 0 && !strchr(" \t\f\r", m_buffer[cut - 1]))
+		{
+			--cut;
+		}
+		if (cut > 0 && fseek(m_file, -(long)(len - cut), SEEK_CUR) == 0)
+		{
+			len = cut;
+		}
+	}
+	if (len > 0)
+	{
+		m_buffer[len] = 0;
+
+		set_buffer(m_buffer, len);
+
+		return true;
+	}
+	return false;
 }
 
 bool scanner::read_stdin()
@@ -38,33 +160,176 @@ bool scanner::read_stdin()
 	{
 		printf("> ");
 	}
-	return fgets(m_buffer, MAX_LINE_BUF, m_file) != nullptr;
+	return read_file();
+}
+
+bool scanner::read_mapped()
+{
+	// the whole file is already in the buffer
+	return false;
+}
+
+bool scanner::read_block()
+{
+	const char* data;
+	size_t size;
+
+	if (!m_reader->next(data, size))
+	{
+		if (m_reader->error() != 0)
+		{
+			message("Unable to read the input: %s", strerror(m_reader->error()));
+		}
+		return false;
+	}
+
+	set_buffer(data, size);
+
+	return true;
+}
+
+// like read_ahead and feed(), the buffer ends at the last line break of the decoded
+// data, or at the last white space when the line is longer than MAX_LINE_BUF; the rest
+// is kept for the next chunk, so no token is split between two chunks
+
+bool scanner::read_filter()
+{
+	string chunk;
+
+	m_data.erase(0, m_data_end);
+	m_data_end = 0;
+
+	while (0 == m_data_end)
+	{
+		size_t len;
+		bool more = m_filter->read(chunk);
+
+		m_data.append(chunk);
+		chunk.clear();
+
+		if (!more)
+		{
+			if (m_data.empty())
+			{
+				return false;
+			}
+
+			m_data_end = m_data.size();
+
+			break;
+		}
+
+		len = m_data.find_last_of("\r\n");
+
+		if (string::npos == len || m_data.size() - len > MAX_LINE_BUF)
+		{
+			len = m_data.find_last_of(" \t\f\r\n");
+		}
+		if (string::npos != len)
+		{
+			m_data_end = len + 1;
+		}
+		else if (m_data.size() >= MAX_LINE_BUF)
+		{
+			m_data_end = m_data.size();
+		}
+	}
+
+	set_buffer(m_data.data(), m_data_end);
+
+	return true;
+}
+
+// thrown when a token continues past the data fed so far
+struct input_needed
+{
+};
+
+bool scanner::read_fed()
+{
+	// reads by the program itself (currentfile) only see the data fed so far
+	if (!m_input_ended && m_scanning)
+	{
+		throw input_needed();
+	}
+	return false;
+}
+
+void scanner::feed(const char* data, size_t len)
+{
+	if (read_file_ptr != &scanner::read_fed)
+	{
+		m_file = nullptr;
+		m_show_prompt = false;
+
+		m_pending.clear();
+
+		set_buffer(m_pending.data(), 0);
+
+		read_file_ptr = &scanner::read_fed;
+	}
+
+	// keep only the unscanned part; column numbers restart at the new chunk
+	m_pending.erase(0, m_curpos - m_pending.data());
+	m_pending.append(data, len);
+
+	set_fed_buffer();
+
+	m_needs_input = false;
+}
+
+void scanner::end_input()
+{
+	if (read_file_ptr != &scanner::read_fed)
+	{
+		feed(nullptr, 0);
+	}
+
+	m_input_ended = true;
+	m_needs_input = false;
+
+	m_endpos = m_pending.data() + m_pending.size();
+}
+
+// like the lines of read_file(), the buffer ends at a line break, or at the last white
+// space of a line longer than MAX_LINE_BUF; the rest waits for more data, or for
+// end_input(), even if it is a long token
+
+void scanner::set_fed_buffer()
+{
+	size_t len = m_pending.find_last_of("\r\n");
+
+	if (string::npos == len || m_pending.size() - len > MAX_LINE_BUF)
+	{
+		len = m_pending.find_last_of(" \t\f\r\n");
+	}
+
+	len = (string::npos == len) ? 0 : len + 1;
+
+	set_buffer(m_pending.data(), len);
 }
 
 bool scanner::get(uint8_t& ch)
 {
 	if (!m_quit)
 	{
-		if (!*m_curpos)
+		if (m_curpos >= m_endpos)
 		{
-			m_buffer[0] = 0;
-
 			if (!(this->*read_file_ptr)())
 			{
 				ch = 0;
 
-				if (feof(m_file))
+				if (is_eof())
 				{
 					m_quit = true;
 				}
 				return false;
 			}
-			m_curpos = m_buffer;
 		}
 
-		m_column = m_curpos - m_buffer;
+		m_column = (int)(m_curpos - m_line);
 
-		ch = *m_curpos;
+		ch = (uint8_t)*m_curpos;
 
 		++m_curpos;
 
@@ -78,7 +343,7 @@ bool scanner::get(uint8_t& ch)
 
 void scanner::unget()
 {
-	if (m_curpos != &m_buffer[0])
+	if (m_curpos != m_start)
 	{
 		--m_curpos;
 
@@ -100,100 +365,209 @@ uint8_t scanner::get()
 
 uint8_t scanner::peek() const
 {
-	return *m_curpos;
+	return m_curpos < m_endpos ? (uint8_t)*m_curpos : 0;
 }
 
-bool scanner::find_bounding_box(double& width, double& height)
+// the DSC index of a seekable file read line by line
+
+void scanner::index_file()
 {
-	long curpos = ftell(m_file);
-	bool result = false;
+	long start = ftell(m_file);
+	string first_line(m_start, m_endpos - m_start);
+	size_t scanned = m_curpos - m_start;
+	size_t offset;
+
+	// the first line is already in the buffer
+	m_dsc.add_line(m_buffer, strcspn(m_buffer, "\r\n"), 0, (size_t)start);
 
-	while (!feof(m_file) && fgets(m_buffer, sizeof(m_buffer) - 1, m_file))
+	offset = (size_t)start;
+
+	while (read_file())
 	{
-		if (m_buffer[0] == '%' && m_buffer[1] == '%')
-		{
-			const char bbox[] = "BoundingBox: ";
-			size_t len = sizeof(bbox) - 1;
-			const char* p = &m_buffer[2];
+		size_t len = m_endpos - m_start;
 
-			if (strncmp(p, bbox, len) == 0)
-			{
-				int32_t x1, y1, x2, y2;
+		m_dsc.add_line(m_start, strcspn(m_start, "\r\n"), offset, offset + len);
 
-				if (sscanf_s(p+len, "%d %d %d %d", &x1, &y1, &x2, &y2) == 4)
-				{
-					width = (double)(x2 - x1);
-					height = (double)(y2 - y1);
+		offset += len;
+	}
 
-					curpos = ftell(m_file);
-					result = true;
-					break;
-				}
-			}
-		}
+	clearerr(m_file);
+
+	fseek(m_file, start, SEEK_SET);
+
+	// back to the first line, where the scan stood, as with a mapped file
+	memcpy(m_buffer, first_line.data(), first_line.size());
+
+	m_buffer[first_line.size()] = 0;
+
+	set_buffer(m_buffer, first_line.size());
+
+	m_curpos += scanned;
+}
+
+// a gzip or zlib compressed input is read through an inflating filter; the
+// current input moves to a scanner owned by the filter
+
+bool scanner::start_inflate()
+{
+	compression_format format;
+	scanner* raw;
+
+	if (!flate_filter::detect(m_curpos, m_endpos - m_curpos, format))
+	{
+		return false;
+	}
+
+	raw = new scanner();
+
+	raw->m_file = m_file;
+	raw->m_reader = m_reader;
+	raw->read_file_ptr = read_file_ptr;
+
+	if (m_start == m_buffer)
+	{
+		// line mode; the first line is already in the buffer
+		memcpy(raw->m_buffer, m_buffer, sizeof(m_buffer));
+
+		raw->set_buffer(raw->m_buffer, m_endpos - m_start);
+	}
+	else
+	{
+		raw->set_buffer(m_start, m_endpos - m_start);
 	}
 
-	fseek(m_file, curpos, SEEK_SET);
+	m_reader = nullptr;
+	m_stable = false;
 
-	return result;
+	load_filter(new flate_filter(raw, format, true));
+
+	return true;
 }
 
 bool scanner::load_file(const char* input_file, double& width, double& height)
 {
-	m_file = fopen(input_file, "rb");
+	//char signature[] = { "%!PSAdobe" };
+	char signature[] = { "%!PS" };
+	bool compressed;
 
-	if (!m_file)
+	if (m_map_files && m_map.open(input_file))
 	{
-		m_error = "Unable to open file: ";
+		m_file = nullptr;
 
-		m_error.append(input_file);
+		set_buffer(m_map.data(), m_map.size());
 
-		return false;
-	}
+		m_stable = true;
 
-	if (read_file())
+		read_file_ptr = &scanner::read_mapped;
+	}
+	else
 	{
-		//char signature[] = { "%!PSAdobe" };
-		char signature[] = { "%!PS" };
+		// "-" is the standard input
+		FILE* file = (strcmp(input_file, "-") == 0) ? stdin : fopen(input_file, "rb");
 
-		if (strncmp(m_curpos, signature, sizeof(signature) - 1) == 0 )
+		if (!file)
 		{
-			m_eps = find_bounding_box(width, height);
+			m_error = "Unable to open file: ";
 
-			read_file_ptr = &scanner::read_file;
+			m_error.append(input_file);
 
-			return true;
+			return false;
+		}
+
+		if (file != stdin && ftell(file) >= 0 && fseek(file, 0, SEEK_CUR) == 0)
+		{
+			// not mappable but seekable; read it line by line
+			m_file = file;
+
+			read_file_ptr = &scanner::read_file;
 		}
 		else
 		{
-			m_error = "Input file is neither a PostScript nor an EPS file";
+			// streams can't be rewound for the pre-scan; read them ahead on another thread
+			m_file = nullptr;
+			m_reader = new read_ahead(file);
+
+			read_file_ptr = &scanner::read_block;
+		}
+
+		try
+		{
+			(this->*read_file_ptr)();
+		}
+		catch (const exception& ex)
+		{
+			m_error = ex.what();
 
 			return false;
 		}
 	}
 
-	return false;
+	compressed = start_inflate();
+
+	if (compressed)
+	{
+		try
+		{
+			(this->*read_file_ptr)();
+		}
+		catch (const exception& ex)
+		{
+			m_error = ex.what();
+
+			return false;
+		}
+	}
+
+	if ((size_t)(m_endpos - m_curpos) < sizeof(signature) - 1
+		|| strncmp(m_curpos, signature, sizeof(signature) - 1) != 0)
+	{
+		m_error = "Input file is neither a PostScript nor an EPS file";
+
+		return false;
+	}
+
+	// compressed inputs can't be pre-scanned; their DSC comments are read as they come
+	if (m_stable)
+	{
+		m_dsc.build(m_map.data(), m_map.size());
+	}
+	else if (m_file && !compressed)
+	{
+		index_file();
+	}
+
+	m_eps = m_dsc.m_has_bounding_box;
+
+	if (m_eps)
+	{
+		width = m_dsc.width();
+		height = m_dsc.height();
+	}
+
+	return true;
 }
 
 void scanner::clear_input()
 {
-	// skip the rest
-	while (*m_curpos)
+	// skip the rest of the line
+	while (m_curpos < m_endpos && *m_curpos != '\n' && *m_curpos != '\r')
 	{
-		if ('\n' == *m_curpos)
-			++m_row;
-
 		++m_curpos;
 	}
 }
 
 void scanner::do_comment()
 {
-	if ('%' == *m_curpos)
+	if ('%' == peek())
 	{
-		++m_curpos;
-		m_token->m_string = m_curpos;
+		const char* start = ++m_curpos;
+
+		clear_input();
+
+		m_token->m_string.assign(start, m_curpos - start);
 		m_token->m_type = ot_dsc;
+
+		return;
 	}
 	else
 	{
@@ -203,11 +577,9 @@ void scanner::do_comment()
 	clear_input();
 }
 
-#define PS_DELIMITER " \t\n\r\f/{}[]()<>%"
-
 bool scanner::is_delimiter(uint8_t ch)
 {
-	return strchr(PS_DELIMITER, ch) != nullptr;
+	return has_char_class(ch, cc_delimiter);
 }
 
 size_t scanner::get_name(char* buf, size_t buf_len)
@@ -223,7 +595,7 @@ size_t scanner::get_name(char* buf, size_t buf_len)
 			unget();
 			break;
 		}
-		else if (isgraph(ch))
+		else if (has_char_class(ch, cc_regular))
 		{
 			buf[i] = (char)ch;
 			++i;
@@ -239,20 +611,48 @@ size_t scanner::get_name(char* buf, size_t buf_len)
 	return i;
 }
 
+// in a mapped file, the name is not copied
+
+string_view scanner::get_name(size_t max_len)
+{
+	if (m_stable)
+	{
+		const char* start = m_curpos;
+
+		while (m_curpos < m_endpos && !is_delimiter((uint8_t)*m_curpos))
+		{
+			if (!has_char_class((uint8_t)*m_curpos, cc_regular))
+			{
+				message("Invalid char in name: %d", (uint8_t)*m_curpos);
+			}
+			++m_curpos;
+		}
+
+		return string_view(start, m_curpos - start);
+	}
+	else
+	{
+		size_t len = get_name(m_token->m_name, max_len);
+
+		return string_view(m_token->m_name, len);
+	}
+}
+
 
 void scanner::read_name()
 {
-	char* name = m_token->m_name;
-	size_t len;
+	string_view name;
 
 	// read only this much
-	len = get_name(name, MAX_NAME_LEN + 2);
+	name = get_name(MAX_NAME_LEN + 2);
 
-	if (len > MAX_NAME_LEN)
+	if (name.size() > MAX_NAME_LEN)
 	{
-		message("Name too long: %d. Max is %d: %s...", len, MAX_NAME_LEN, name);
+		message("Name too long: %d. Max is %d: %.*s...", (int)name.size(), MAX_NAME_LEN, MAX_NAME_LEN, name.data());
 	}
 
+	m_token->m_view = name;
+
 		m_token->m_type = ot_name;
 }
 
@@ -265,9 +665,8 @@ void scanner::do_name()
 
 void scanner::do_literal()
 {
-	char* name = m_token->m_name;
+	string_view name;
 	bool literal = true;
-	size_t len;
 	uint8_t ch;
 
 	ch = peek();
@@ -284,17 +683,17 @@ void scanner::do_literal()
 	}
 
 	// read only this much
-	len = get_name(name, MAX_NAME_LEN + 2);
+	name = get_name(MAX_NAME_LEN + 2);
 
-	if (len > MAX_NAME_LEN)
+	if (name.size() > MAX_NAME_LEN)
 	{
-		message("Name too long: %d. Max is %d: %s...", len, MAX_NAME_LEN, name);
+		message("Name too long: %d. Max is %d: %.*s...", (int)name.size(), MAX_NAME_LEN, MAX_NAME_LEN, name.data());
 	}
-	else if (0 == len)
+	else if (name.empty())
 	{
 		if (literal)
 		{
-			name[0] = '/';
+			name = "/";
 		}
 		else
 		{
@@ -302,6 +701,8 @@ void scanner::do_literal()
 		}
 	}
 
+	m_token->m_view = name;
+
 	if (literal)
 	{
 		m_token->m_type = ot_literal;
@@ -312,65 +713,216 @@ void scanner::do_literal()
 	}
 }
 
-static operand_type get_number_type(const char* start, const char* end)
+// powers of ten that are exact in a double
+static const double exact_powers_of_10[] =
+{
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+#define MAX_MANTISSA_DIGITS 19 // what fits in a uint64_t
+#define MAX_EXACT_MANTISSA (1ULL << 53)
+
+static int32_t digit_value(uint8_t ch)
 {
-	while (start < end)
+	if (has_char_class(ch, cc_digit))
 	{
-		if ('.' == *start || 'e' == *start || 'E' == *start)
-		{
-			return operand_type::ot_real;
-		}
-		++start;
+		return ch - '0';
 	}
-
-	return operand_type::ot_integer;
+	else if (has_char_class(ch, cc_alpha))
+	{
+		return (ch | 0x20) - 'a' + 10;
+	}
+	return 36;
 }
 
+// reads integers, reals, exponents and base#digits in one pass; if the
+// token is not a valid number, it is read as a name
+
 void scanner::read_number()
 {
+	const char* p = m_curpos;
+	const char* end = m_endpos;
+	bool negative = false;
+	bool is_real = false;
+	bool truncated = false; // mantissa has more than MAX_MANTISSA_DIGITS digits
+	uint64_t mantissa = 0;
+	int32_t significant = 0;
+	int32_t digit_count = 0;
+	int32_t exponent = 0;
 	double value;
-	char* endp;
-
-	endp = m_curpos;
-
-	value = strtod(m_curpos, &endp);
 
-	if (is_delimiter((uint8_t)*endp))
+	if ('+' == *p || '-' == *p)
 	{
+		negative = ('-' == *p);
+		++p;
+	}
 
-		m_token->m_type = get_number_type(m_curpos, endp);
-		m_token->m_number = value;
-
-		m_curpos = endp;
+	for (; p < end && has_char_class((uint8_t)*p, cc_digit); ++p, ++digit_count)
+	{
+		if (significant < MAX_MANTISSA_DIGITS)
+		{
+			mantissa = mantissa * 10 + (uint64_t)(*p - '0');
 
-		return;
+			if (mantissa)
+			{
+				++significant;
+			}
+		}
+		else
+		{
+			++exponent;
+			truncated = true;
+		}
 	}
+
 	// base#number
-	else if ('#' == *endp && isdigit((uint8_t)*m_curpos))
+	if (p < end && '#' == *p && p == m_curpos + digit_count && digit_count > 0)
 	{
-		// if 'value' is an integer
-		if (get_number_type(m_curpos, endp) == ot_integer)
+		if (!truncated && mantissa >= 2 && mantissa <= 36)
 		{
-			int32_t base = (int32_t)value;
+			const int32_t base = (int32_t)mantissa;
+			const char* start = ++p;
+			uint64_t result = 0;
 
-			if (base >= 2 && base <= 36)
+			for (; p < end && !is_delimiter((uint8_t)*p); ++p)
 			{
-				value = strtol(endp+1, &endp, base);
+				const int32_t digit = digit_value((uint8_t)*p);
 
-				if (is_delimiter((uint8_t)*endp))
+				if (digit >= base)
 				{
-					m_token->m_type = ot_integer;
-					m_token->m_number = value;
+					break;
+				}
+
+				result = result * base + digit;
+
+				if (result > 0xFFFFFFFFULL)
+				{
+					break;
+				}
+			}
+
+			if (p > start && (p == end || is_delimiter((uint8_t)*p)))
+			{
+				// 32 bits, two's complement
+				m_token->m_type = ot_integer;
+				m_token->m_number = (double)(int32_t)(uint32_t)result;
+
+				m_curpos = p;
+
+				return;
+			}
+		}
+
+		read_name();
+
+		return;
+	}
+
+	if (p < end && '.' == *p)
+	{
+		is_real = true;
 
-					m_curpos = endp;
+		for (++p; p < end && has_char_class((uint8_t)*p, cc_digit); ++p, ++digit_count)
+		{
+			if (significant < MAX_MANTISSA_DIGITS)
+			{
+				mantissa = mantissa * 10 + (uint64_t)(*p - '0');
 
-					return;
+				if (mantissa)
+				{
+					++significant;
 				}
+				--exponent;
+			}
+			else
+			{
+				truncated = true;
 			}
 		}
 	}
 
-	read_name();	
+	if (0 == digit_count)
+	{
+		read_name();
+
+		return;
+	}
+
+	if (p < end && ('e' == *p || 'E' == *p))
+	{
+		const char* q = p + 1;
+		bool negative_exponent = false;
+		int32_t exp_value = 0;
+
+		if (q < end && ('+' == *q || '-' == *q))
+		{
+			negative_exponent = ('-' == *q);
+			++q;
+		}
+		if (q >= end || !has_char_class((uint8_t)*q, cc_digit))
+		{
+			read_name();
+
+			return;
+		}
+		for (; q < end && has_char_class((uint8_t)*q, cc_digit); ++q)
+		{
+			// large enough to overflow or underflow any double
+			if (exp_value < 100000)
+			{
+				exp_value = exp_value * 10 + (*q - '0');
+			}
+		}
+
+		exponent += negative_exponent ? -exp_value : exp_value;
+		is_real = true;
+		p = q;
+	}
+
+	if (p < end && !is_delimiter((uint8_t)*p))
+	{
+		read_name();
+
+		return;
+	}
+
+	if (!is_real && !truncated && mantissa <= (negative ? 2147483648ULL : 2147483647ULL))
+	{
+		m_token->m_type = ot_integer;
+		m_token->m_number = negative ? -(double)mantissa : (double)mantissa;
+
+		m_curpos = p;
+
+		return;
+	}
+
+	if (!truncated && mantissa <= MAX_EXACT_MANTISSA && exponent >= -22 && exponent <= 22)
+	{
+		value = (double)mantissa;
+
+		if (exponent < 0)
+		{
+			value /= exact_powers_of_10[-exponent];
+		}
+		else
+		{
+			value *= exact_powers_of_10[exponent];
+		}
+	}
+	else
+	{
+		// long mantissa or large exponent; let strtod() do the exact rounding
+		string tmp(m_curpos, p - m_curpos);
+
+		value = fabs(strtod(tmp.c_str(), nullptr));
+	}
+
+	// integers that don't fit in 32 bits become reals
+	m_token->m_type = ot_real;
+	m_token->m_number = negative ? -value : value;
+
+	m_curpos = p;
 }
 
 void scanner::do_number()
@@ -382,18 +934,18 @@ void scanner::do_number()
 
 void scanner::try_number()
 {
-	char* curpos = m_curpos - 1;
+	const char* curpos = m_curpos - 1;
 
 	if ('+' == *curpos || '-' == *curpos)
 	{
 		++curpos;
 	}
-	if ('.' == *curpos)
+	if (curpos < m_endpos && '.' == *curpos)
 	{
 		++curpos;
 	}
 
-	if (isdigit((uint8_t)*curpos))
+	if (curpos < m_endpos && has_char_class((uint8_t)*curpos, cc_digit))
 	{
 		do_number();
 	}
@@ -416,7 +968,19 @@ void scanner::do_angular_on()
 	}
 	else if ('~' == ch)
 	{
-		message("Base 85 ASCII is not yet supported");
+		get(); // skip
+
+		try
+		{
+			m_show_prompt = false;
+			do_ascii85_string();
+			m_show_prompt = true;
+		}
+		catch (const exception&)
+		{
+			m_show_prompt = true;
+			throw;
+		}
 	}
 	else
 	{
@@ -426,10 +990,10 @@ void scanner::do_angular_on()
 			do_hex_string_on();
 			m_show_prompt = true;
 		}
-		catch (const exception& ex)
+		catch (const exception&)
 		{
 			m_show_prompt = true;
-			throw ex;
+			throw;
 		}
 	}
 }
@@ -454,7 +1018,7 @@ void scanner::do_angular_off()
 
 void scanner::do_tilde()
 {
-	if (peek() == '>') // ~> must be read by do_ascci_text_b85 (not yet supported)
+	if (peek() == '>') // ~> is read by decode_ascii85()
 	{
 		message("Missing '<~");
 	}
@@ -464,131 +1028,825 @@ void scanner::do_tilde()
 	}
 }
 
+// the data of '<~' up to and including '~>'
+
+void scanner::decode_ascii85(string& out)
+{
+	ascii85_decoder decoder;
+
+	while (!decoder.eod())
+	{
+		if (m_curpos >= m_endpos && !(this->*read_file_ptr)())
+		{
+			message("ASCII85 string has no matching '~>'");
+		}
+
+		m_curpos += decoder.decode(m_curpos, m_endpos - m_curpos, out);
+	}
+
+	if (get() != '>')
+	{
+		message("Invalid ASCII85 string: '~' must be followed by '>'");
+	}
+
+	decoder.finish(out);
+}
+
+void scanner::do_ascii85_string()
+{
+	m_token->m_string.clear();
+
+	decode_ascii85(m_token->m_string);
+
+	m_token->m_view = m_token->m_string;
+	m_token->m_type = ot_text_string;
+}
+
+// the scanner reads the output of 'filter' and takes ownership of it
+
+void scanner::load_filter(decode_filter* filter)
+{
+	m_filter = filter;
+
+	m_file = nullptr;
+
+	set_buffer(m_buffer, 0);
+
+	read_file_ptr = &scanner::read_filter;
+}
+
+// the unread part of the current buffer, refilled if empty; used by filters reading from this scanner
+
+string_view scanner::read_raw()
+{
+	m_read_directly = true;
+
+	if (m_curpos >= m_endpos && !(this->*read_file_ptr)())
+	{
+		return string_view();
+	}
+
+	return string_view(m_curpos, m_endpos - m_curpos);
+}
+
+void scanner::skip_raw(size_t len)
+{
+	m_curpos += len;
+}
+
 void scanner::do_hex_string_on()
 {
-	int counter = 0;
 	string& str = m_token->m_string;
-	uint8_t buf[3] = { 0 };
-	uint8_t ch;
+	hex_decoder decoder;
 
 	str.clear();
 
-	while (get(ch))
+	// the decoder takes whole buffers; get() is only used to refill them
+	while (!decoder.eod())
 	{
-		if (isxdigit(ch))
+		if (m_curpos >= m_endpos && !(this->*read_file_ptr)())
 		{
-			buf[counter] = ch;
-			++counter;
+			message("Unexpected end of file");
+		}
 
-			if (2 == counter)
-			{
-				uint8_t val = (uint8_t)strtol((char*)buf, nullptr, 16);
+		m_curpos += decoder.decode(m_curpos, m_endpos - m_curpos, str);
+	}
 
-				counter = 0;
+	decoder.finish(str);
 
-				str.push_back((char)val);
-			}
-		}
-		else if ('>' == ch)
+	m_token->m_type = ot_hex_string;
+	m_token->m_view = str;
+}
+
+static inline bool is_string_special(uint8_t ch)
+{
+	return '(' == ch || ')' == ch || '\\' == ch || '\r' == ch;
+}
+
+// the first '(', ')', '\' or CR in [p, end), or end; everything else is copied as is
+
+static const char* find_string_special(const char* p, const char* end)
+{
+#ifdef HAS_SSE2
+	const __m128i open = _mm_set1_epi8('(');
+	const __m128i close = _mm_set1_epi8(')');
+	const __m128i backslash = _mm_set1_epi8('\\');
+	const __m128i cr = _mm_set1_epi8('\r');
+
+	while (end - p >= 16)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i*)p);
+		__m128i found = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, open), _mm_cmpeq_epi8(v, close)),
+			_mm_or_si128(_mm_cmpeq_epi8(v, backslash), _mm_cmpeq_epi8(v, cr)));
+
+		if (_mm_movemask_epi8(found) != 0)
 		{
-			if (1 == counter)
-			{
-				uint8_t val;
+			break; // it's within these 16 bytes
+		}
+		p += 16;
+	}
+#endif
+	while (p < end && !is_string_special((uint8_t)*p))
+	{
+		++p;
+	}
 
-				buf[1] = '0';
+	return p;
+}
 
-				val = (uint8_t)strtol((char*)buf, nullptr, 16);
+// the next character without consuming it; refills the buffer if needed
 
-				str.push_back((char)val);
-			}
+bool scanner::peek_string_char(uint8_t& ch)
+{
+	if (m_curpos >= m_endpos && !(this->*read_file_ptr)())
+	{
+		return false;
+	}
 
-			m_token->m_type = ot_hex_string;
+	ch = (uint8_t)*m_curpos;
 
-			return;
+	return true;
+}
+
+// the character(s) after a backslash
+
+void scanner::do_string_escape(string& str)
+{
+	uint8_t ch;
+
+	if (!peek_string_char(ch))
+	{
+		return; // reported by the caller
+	}
+
+	++m_curpos;
+
+	switch (ch)
+	{
+	case 'n':
+		str.push_back('\n');
+		break;
+	case 'r':
+		str.push_back('\r');
+		break;
+	case 't':
+		str.push_back('\t');
+		break;
+	case 'b':
+		str.push_back('\b');
+		break;
+	case 'f':
+		str.push_back('\f');
+		break;
+	case '\r':
+		// line continuation; CR LF counts as one end of line
+		if (peek_string_char(ch) && '\n' == ch)
+		{
+			++m_curpos;
 		}
-		else
+		break;
+	case '\n':
+		break;
+	default:
+		if (ch >= '0' && ch <= '7')
 		{
-			if (!isspace(ch))
+			// one to three octal digits; overflow is ignored
+			int value = ch - '0';
+
+			for (int i = 1; i < 3 && peek_string_char(ch) && ch >= '0' && ch <= '7'; ++i)
 			{
-				message("Character %c is not a hex number", ch);
+				value = value * 8 + (ch - '0');
+
+				++m_curpos;
 			}
+
+			str.push_back((char)(value & 0xFF));
 		}
+		else
+		{
+			// \\, \(, \) and unknown escapes: the character itself
+			str.push_back((char)ch);
+		}
+		break;
 	}
-
-	message("Unexpected end of file");
 }
 
-/*
-* TODO
-\n line feed (LF)
-\r carriage return (CR)
-\t horizontal tab
-\b backspace
-\f form feed
-\\ backslash
-\( left parenthesis
-\) right parenthesis
-\ddd character code ddd (octal)
-*/
+// Runs of ordinary characters are copied whole. In a mapped file, a string without escapes
+// or CRs is used in place; otherwise it's collected in m_string
+
 void scanner::do_text_string_on()
 {
 	string& str = m_token->m_string;
+	const char* start = m_curpos; // the run not yet copied to 'str'
+	bool copied = !m_stable;
 	int paren = 1;
-	uint8_t ch;
 
 	str.clear();
 
 	m_show_prompt = false;
 
-	while (get(ch))
+	while (true)
 	{
+		const char* p = find_string_special(m_curpos, m_endpos);
+		uint8_t ch;
+
+		if (p == m_endpos)
+		{
+			str.append(start, p - start);
+
+			m_curpos = p;
+
+			if (!(this->*read_file_ptr)())
+			{
+				m_show_prompt = true;
+
+				message("Text string has no matching ')");
+			}
+
+			start = m_curpos;
+			copied = true;
+
+			continue;
+		}
+
+		ch = (uint8_t)*p;
+
+		m_curpos = p + 1;
+
 		if ('(' == ch)
 		{
 			++paren;
-			str.push_back('(');
 		}
 		else if (')' == ch)
 		{
-			--paren;
-
-			if (0 == paren)
+			if (0 == --paren)
 			{
+				if (copied)
+				{
+					str.append(start, p - start);
+
+					m_token->m_view = str;
+				}
+				else
+				{
+					m_token->m_view = string_view(start, p - start);
+				}
+
 				m_token->m_type = ot_text_string;
 
 				m_show_prompt = true;
 
 				return;
 			}
+		}
+		else
+		{
+			str.append(start, p - start);
+
+			if ('\\' == ch)
+			{
+				do_string_escape(str);
+			}
 			else
 			{
-				str.push_back(')');
+				// CR and CR LF are read as LF
+				str.push_back('\n');
+
+				if (peek_string_char(ch) && '\n' == ch)
+				{
+					++m_curpos;
+				}
 			}
+
+			start = m_curpos;
+			copied = true;
+		}
+	}
+}
+
+// Level 2 binary encoding; system name indices as in the PostScript Language Reference, appendix F
+
+static const char* const system_names[] =
+{
+	"abs", "add", "aload", "anchorsearch", "and", "arc", "arcn", "arct", "arcto", "array",
+	"ashow", "astore", "awidthshow", "begin", "bind", "bitshift", "ceiling", "charpath", "clear", "cleartomark",
+	"clip", "clippath", "closepath", "concat", "concatmatrix", "copy", "copypage", "cos", "count", "counttomark",
+	"currentcmykcolor", "currentdash", "currentdict", "currentfile", "currentfont", "currentgray", "currentgstate", "currenthsbcolor", "currentlinecap", "currentlinejoin",
+	"currentlinewidth", "currentmatrix", "currentpoint", "currentrgbcolor", "currentshared", "curveto", "cvi", "cvlit", "cvn", "cvr",
+	"cvrs", "cvs", "cvx", "def", "defineusername", "dict", "div", "dtransform", "dup", "end",
+	"eoclip", "eofill", "eoviewclip", "eq", "exch", "exec", "exit", "file", "fill", "findfont",
+	"flattenpath", "floor", "flush", "flushfile", "for", "forall", "ge", "get", "getinterval", "grestore",
+	"gsave", "gstate", "gt", "identmatrix", "idiv", "idtransform", "if", "ifelse", "image", "imagemask",
+	"index", "ineofill", "infill", "initviewclip", "inueofill", "inufill", "invertmatrix", "itransform", "known", "le",
+	"length", "lineto", "load", "loop", "lt", "makefont", "matrix", "maxlength", "mod", "moveto",
+	"mul", "ne", "neg", "newpath", "not", "null", "or", "pathbbox", "pathforall", "pop",
+	"print", "printobject", "put", "putinterval", "rcurveto", "read", "readhexstring", "readline", "readstring", "rectclip",
+	"rectfill", "rectstroke", "rectviewclip", "repeat", "restore", "rlineto", "rmoveto", "roll", "rotate", "round",
+	"save", "scale", "scalefont", "search", "selectfont", "setbbox", "setcachedevice", "setcachedevice2", "setcharwidth", "setcmykcolor",
+	"setdash", "setfont", "setgray", "setgstate", "sethsbcolor", "setlinecap", "setlinejoin", "setlinewidth", "setmatrix", "setrgbcolor",
+	"setshared", "shareddict", "show", "showpage", "stop", "stopped", "store", "string", "stringwidth", "stroke",
+	"strokepath", "sub", "systemdict", "token", "transform", "translate", "truncate", "type", "uappend", "ucache",
+	"ueofill", "ufill", "undef", "upath", "userdict", "ustroke", "viewclip", "viewclippath", "where", "widthshow",
+	"write", "writehexstring", "writeobject", "writestring", "wtranslation", "xor", "xshow", "xyshow", "yshow", "FontDirectory",
+	"SharedFontDirectory", "Courier", "Courier-Bold", "Courier-BoldOblique", "Courier-Oblique", "Helvetica", "Helvetica-Bold", "Helvetica-BoldOblique", "Helvetica-Oblique", "Symbol",
+	"Times-Bold", "Times-BoldItalic", "Times-Italic", "Times-Roman", "execuserobject", "currentcolor", "currentcolorspace", "currentglobal", "execform", "filter",
+	"findresource", "globaldict", "makepattern", "setcolor", "setcolorspace", "setglobal", "setpagedevice", "setpattern"
+};
+
+static constexpr size_t system_name_count = sizeof(system_names) / sizeof(system_names[0]);
+
+static_assert(system_name_count == 228, "setpattern must be system name 227");
+
+enum binary_token_type : uint8_t
+{
+	bt_sequence_ieee_high = 128,
+	bt_sequence_ieee_low,
+	bt_sequence_native_high,
+	bt_sequence_native_low,
+	bt_int32_high,
+	bt_int32_low,
+	bt_int16_high,
+	bt_int16_low,
+	bt_int8,
+	bt_fixed,
+	bt_real_high,
+	bt_real_low,
+	bt_real_native,
+	bt_boolean,
+	bt_string8,
+	bt_string16_high,
+	bt_string16_low,
+	bt_system_name_literal,
+	bt_system_name,
+	bt_user_name_literal,
+	bt_user_name,
+	bt_number_array,
+	bt_last = 159
+};
+
+enum binary_object_type : uint8_t
+{
+	bo_null = 0,
+	bo_integer = 1,
+	bo_real = 2,
+	bo_name = 3,
+	bo_boolean = 4,
+	bo_string = 5,
+	bo_immediate_name = 6,
+	bo_array = 9,
+	bo_mark = 10
+};
+
+static constexpr int MAX_BINARY_DEPTH = 64;
+
+static uint32_t get_uint32(const uint8_t* p, bool low_first)
+{
+	return low_first ? (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24)
+		: ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+static uint16_t get_uint16(const uint8_t* p, bool low_first)
+{
+	return low_first ? (uint16_t)(p[0] | (p[1] << 8)) : (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static double get_ieee_real(const uint8_t* p, bool low_first)
+{
+	uint32_t bits = get_uint32(p, low_first);
+	float value;
+
+	memcpy(&value, &bits, sizeof(value));
+
+	return value;
+}
+
+static double get_native_real(const uint8_t* p)
+{
+	float value;
+
+	memcpy(&value, p, sizeof(value));
+
+	return value;
+}
+
+// size of a number in the representation 'r' of a fixed point number or homogeneous array; 0 if invalid
+static size_t number_size(uint8_t r)
+{
+	r &= 0x7F;
+
+	if (r < 32 || 48 == r || 49 == r)
+	{
+		return 4;
+	}
+	else if (r < 48)
+	{
+		return 2;
+	}
+	return 0;
+}
+
+static double get_number(const uint8_t* p, uint8_t r, operand_type& type)
+{
+	const bool low_first = (r & 0x80) != 0;
+
+	r &= 0x7F;
+
+	if (48 == r)
+	{
+		type = ot_real;
+
+		return get_ieee_real(p, low_first);
+	}
+	else if (49 == r)
+	{
+		type = ot_real;
+
+		return get_native_real(p);
+	}
+	else
+	{
+		int32_t value = (r < 32) ? (int32_t)get_uint32(p, low_first) : (int16_t)get_uint16(p, low_first);
+		int scale = (r < 32) ? r : r - 32;
+
+		if (0 == scale)
+		{
+			type = ot_integer;
+
+			return value;
 		}
-		else if( isgraph(ch))
+		type = ot_real;
+
+		return ldexp((double)value, -scale);
+	}
+}
+
+void scanner::read_binary(uint8_t* buf, size_t len)
+{
+	for (size_t i = 0; i < len; ++i)
+	{
+		if (!get(buf[i]))
+		{
+			message("Binary token is truncated");
+		}
+	}
+}
+
+// the next 'len' bytes of the input; in place for mapped files, otherwise copied to m_binary_data
+
+string_view scanner::read_binary_view(size_t len)
+{
+	if (m_stable && (size_t)(m_endpos - m_curpos) >= len)
+	{
+		string_view view(m_curpos, len);
+
+		m_curpos += len;
+
+		return view;
+	}
+	else
+	{
+		m_binary_data.resize(len);
+
+		read_binary((uint8_t*)&m_binary_data[0], len);
+
+		return string_view(m_binary_data);
+	}
+}
+
+void scanner::add_binary_object(operand_type type, double number, string_view view)
+{
+	binary_object obj;
+
+	obj.m_type = type;
+	obj.m_number = number;
+	obj.m_view = view;
+
+	m_binary_objects.push_back(obj);
+}
+
+void scanner::do_binary_token(uint8_t ch)
+{
+	uint8_t buf[4];
+
+	switch (ch)
+	{
+	case bt_int32_high:
+	case bt_int32_low:
+		read_binary(buf, 4);
+		m_token->m_number = (int32_t)get_uint32(buf, bt_int32_low == ch);
+		m_token->m_type = ot_integer;
+		break;
+	case bt_int16_high:
+	case bt_int16_low:
+		read_binary(buf, 2);
+		m_token->m_number = (int16_t)get_uint16(buf, bt_int16_low == ch);
+		m_token->m_type = ot_integer;
+		break;
+	case bt_int8:
+		read_binary(buf, 1);
+		m_token->m_number = (int8_t)buf[0];
+		m_token->m_type = ot_integer;
+		break;
+	case bt_fixed:
 		{
-			if (ch != '\\')
+			size_t size;
+
+			read_binary(buf, 1);
+
+			size = number_size(buf[0]);
+
+			// 49 (native real) is only valid in homogeneous arrays
+			if (0 == size || 48 == (buf[0] & 0x7F) || 49 == (buf[0] & 0x7F))
 			{
-				str.push_back((char)ch);
+				message("Invalid binary number representation: %d", buf[0]);
 			}
+
+			uint8_t r = buf[0];
+
+			read_binary(buf, size);
+			m_token->m_number = get_number(buf, r, m_token->m_type);
 		}
-		else
+		break;
+	case bt_real_high:
+	case bt_real_low:
+		read_binary(buf, 4);
+		m_token->m_number = get_ieee_real(buf, bt_real_low == ch);
+		m_token->m_type = ot_real;
+		break;
+	case bt_real_native:
+		read_binary(buf, 4);
+		m_token->m_number = get_native_real(buf);
+		m_token->m_type = ot_real;
+		break;
+	case bt_boolean:
+		read_binary(buf, 1);
+		m_token->m_view = buf[0] ? "true" : "false";
+		m_token->m_type = ot_name;
+		break;
+	case bt_string8:
+	case bt_string16_high:
+	case bt_string16_low:
 		{
-			if (isspace(ch))
+			size_t len;
+
+			if (bt_string8 == ch)
 			{
-				str.push_back(' '); 
+				read_binary(buf, 1);
+				len = buf[0];
 			}
 			else
 			{
-				m_show_prompt = true;
+				read_binary(buf, 2);
+				len = get_uint16(buf, bt_string16_low == ch);
+			}
+			if (m_stable && (size_t)(m_endpos - m_curpos) >= len)
+			{
+				m_token->m_view = string_view(m_curpos, len);
+
+				m_curpos += len;
+			}
+			else
+			{
+				m_token->m_string.resize(len);
+
+				read_binary((uint8_t*)&m_token->m_string[0], len);
 
-				message("Invalid char: %d (%c)", ch, ch);
+				m_token->m_view = m_token->m_string;
 			}
+			m_token->m_type = ot_text_string;
 		}
+		break;
+	case bt_system_name_literal:
+	case bt_system_name:
+		read_binary(buf, 1);
+		if (buf[0] >= system_name_count)
+		{
+			message("Undefined system name index: %d", buf[0]);
+		}
+		m_token->m_view = system_names[buf[0]];
+		m_token->m_type = (bt_system_name == ch) ? ot_name : ot_literal;
+		break;
+	case bt_user_name_literal:
+	case bt_user_name:
+		read_binary(buf, 1);
+		message("Undefined user name index: %d", buf[0]);
+		break;
+	case bt_number_array:
+		do_binary_array(ch);
+		break;
+	default:
+		if (ch <= bt_sequence_native_low)
+		{
+			do_binary_sequence(ch);
+		}
+		else
+		{
+			message("Invalid binary token: %d", ch);
+		}
+		break;
+	}
+}
+
+// homogeneous number array; returned as [ n1 n2 ... ]
+
+void scanner::do_binary_array(uint8_t ch)
+{
+	uint8_t buf[4];
+	uint8_t r;
+	size_t size, count;
+
+	read_binary(buf, 1);
+
+	r = buf[0];
+	size = number_size(r);
+
+	if (0 == size)
+	{
+		message("Invalid binary number representation: %d", r);
 	}
 
-	m_show_prompt = true;
+	read_binary(buf, 2);
+
+	count = get_uint16(buf, (r & 0x80) != 0);
+
+	m_binary_objects.clear();
+	m_binary_objects.reserve(count + 1);
+	m_binary_pos = 0;
 
-	message("Text string has no matching ')");
+	for (size_t i = 0; i < count; ++i)
+	{
+		operand_type type;
+		double number;
+
+		read_binary(buf, size);
+
+		number = get_number(buf, r, type);
+
+		add_binary_object(type, number);
+	}
+	add_binary_object(ot_array_marker_off);
+
+	m_token->m_type = ot_array_marker_on;
+}
+
+// binary object sequence; the objects are flattened into the tokens that
+// would have produced them. The top-level array is executed as soon as it
+// is scanned, so its elements are returned one after another
+
+void scanner::do_binary_sequence(uint8_t ch)
+{
+	const bool low_first = (bt_sequence_ieee_low == ch || bt_sequence_native_low == ch);
+	const bool ieee = (bt_sequence_ieee_high == ch || bt_sequence_ieee_low == ch);
+	uint8_t buf[8];
+	size_t header_len, count, total_len;
+	string_view data;
+
+	read_binary(buf, 3);
+
+	if (buf[0] != 0)
+	{
+		header_len = 4;
+		count = buf[0];
+		total_len = get_uint16(buf + 1, low_first);
+	}
+	else
+	{
+		header_len = 8;
+		read_binary(buf + 3, 4);
+		count = get_uint16(buf + 1, low_first);
+		total_len = get_uint32(buf + 3, low_first);
+	}
+
+	if (total_len < header_len + count * 8)
+	{
+		message("Invalid binary object sequence");
+	}
+
+	data = read_binary_view(total_len - header_len);
+
+	m_binary_objects.clear();
+	m_binary_pos = 0;
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		decode_binary_object((const uint8_t*)data.data(), data.size(), i * 8, low_first, ieee, 0);
+	}
+
+	if (m_binary_objects.empty())
+	{
+		return;
+	}
+
+	const binary_object& first = m_binary_objects[0];
+
+	m_token->m_type = first.m_type;
+	m_token->m_number = first.m_number;
+	m_token->m_view = first.m_view;
+
+	m_binary_pos = 1;
+}
+
+void scanner::decode_binary_object(const uint8_t* objects, size_t len, size_t offset, bool low_first, bool ieee, int depth)
+{
+	const uint8_t* obj = objects + offset;
+	const bool executable = (obj[0] & 0x80) != 0;
+	const uint16_t length = get_uint16(obj + 2, low_first);
+	const uint32_t value = get_uint32(obj + 4, low_first);
+
+	if (depth > MAX_BINARY_DEPTH)
+	{
+		message("Binary object sequence is nested too deeply");
+	}
+	// each object is at least 8 bytes; more tokens than bytes means shared or cyclic arrays
+	if (m_binary_objects.size() > len)
+	{
+		message("Invalid binary object sequence");
+	}
+
+	switch (obj[0] & 0x7F)
+	{
+	case bo_null:
+		add_binary_object(ot_name, 0.0, "null");
+		break;
+	case bo_integer:
+		add_binary_object(ot_integer, (int32_t)value);
+		break;
+	case bo_real:
+		if (length != 0)
+		{
+			add_binary_object(ot_real, ldexp((double)(int32_t)value, -(int)length));
+		}
+		else
+		{
+			add_binary_object(ot_real, ieee ? get_ieee_real(obj + 4, low_first) : get_native_real(obj + 4));
+		}
+		break;
+	case bo_name:
+	case bo_immediate_name:
+		{
+			string_view name;
+
+			if (0xFFFF == length)
+			{
+				if (value >= system_name_count)
+				{
+					message("Undefined system name index: %u", value);
+				}
+				name = system_names[value];
+			}
+			else if (0 == length)
+			{
+				message("Undefined user name index: %u", value);
+			}
+			else if (value > len || length > len - value)
+			{
+				message("Invalid binary object sequence");
+			}
+			else
+			{
+				name = string_view((const char*)objects + value, length);
+			}
+			if ((obj[0] & 0x7F) == bo_immediate_name)
+			{
+				add_binary_object(ot_constant, 0.0, name);
+			}
+			else
+			{
+				add_binary_object(executable ? ot_name : ot_literal, 0.0, name);
+			}
+		}
+		break;
+	case bo_boolean:
+		add_binary_object(ot_name, 0.0, value ? "true" : "false");
+		break;
+	case bo_string:
+		if (value > len || length > len - value)
+		{
+			message("Invalid binary object sequence");
+		}
+		add_binary_object(ot_text_string, 0.0, string_view((const char*)objects + value, length));
+		break;
+	case bo_array:
+		if (value > len || (size_t)length * 8 > len - value)
+		{
+			message("Invalid binary object sequence");
+		}
+		add_binary_object(executable ? ot_procedure_marker_on : ot_array_marker_on);
+
+		for (size_t i = 0; i < length; ++i)
+		{
+			decode_binary_object(objects, len, value + i * 8, low_first, ieee, depth + 1);
+		}
+
+		add_binary_object(executable ? ot_procedure_marker_off : ot_array_marker_off);
+		break;
+	case bo_mark:
+		add_binary_object(ot_name, 0.0, "mark");
+		break;
+	default:
+		message("Invalid binary object type: %d", obj[0] & 0x7F);
+		break;
+	}
 }
 
 void scanner::get_token_ex(token& tkn)
@@ -599,13 +1857,26 @@ void scanner::get_token_ex(token& tkn)
 
 	m_token = &tkn;
 
+	if (m_binary_pos < m_binary_objects.size())
+	{
+		const binary_object& obj = m_binary_objects[m_binary_pos++];
+
+		tkn.m_type = obj.m_type;
+		tkn.m_number = obj.m_number;
+		tkn.m_view = obj.m_view;
+
+		return;
+	}
+
 	while (get(ch))
 	{		
-		if (isalpha(ch))
+		const uint8_t cls = char_classes.m_class[ch];
+
+		if (cls & cc_alpha)
 		{
 			do_name();
 		}
-		else if (isdigit(ch))
+		else if (cls & cc_digit)
 		{
 			do_number();
 		}
@@ -613,7 +1884,7 @@ void scanner::get_token_ex(token& tkn)
 		{
 			do_literal();
 		}
-		else if (isgraph(ch))
+		else if (cls & (cc_regular | cc_special))
 		{
 			switch (ch)
 			{			
@@ -663,14 +1934,20 @@ void scanner::get_token_ex(token& tkn)
 		}
 		else
 		{
-			if (isspace(ch))
+			if (cls & cc_whitespace)
 			{
 				if ('\n' == ch)
 				{
 					++m_row;
+
+					m_line = m_curpos;
 				}
 				continue;
 			}
+			else if (ch >= bt_sequence_ieee_high && ch <= bt_last)
+			{
+				do_binary_token(ch);
+			}
 			else
 			{
 				message("Invalid char: %d (%c)", ch, ch);				
@@ -687,6 +1964,22 @@ bool scanner::is_interactive() const
 
 bool scanner::is_eof() const
 {
+	if (m_filter)
+	{
+		return m_filter->eof() && m_data_end == m_data.size() && m_curpos >= m_endpos;
+	}
+	else if (m_reader)
+	{
+		return m_reader->eof() && m_curpos >= m_endpos;
+	}
+	else if (&scanner::read_fed == read_file_ptr)
+	{
+		return m_input_ended && m_curpos >= m_endpos;
+	}
+	else if (!m_file) // mapped
+	{
+		return m_curpos >= m_endpos;
+	}
 	return feof(m_file) != 0;
 }
 
@@ -697,18 +1990,49 @@ bool scanner::is_eps() const
 
 bool scanner::get_token(token& tkn, bool& error)
 {
+	const char* start = m_curpos;
+	const char* line = m_line;
+	int row = m_row;
+
 	try
 	{
 		if (!m_quit)
 		{
+			m_scanning = true;
+
 			get_token_ex(tkn);
 
+			m_scanning = false;
+
 			return true;
 		}
 	}
+	catch (const input_needed&)
+	{
+		// start over when the rest of the token has been fed
+		m_scanning = false;
+		m_needs_input = true;
+
+		m_curpos = start;
+		m_line = line;
+		m_row = row;
+
+		m_binary_objects.clear();
+		m_binary_pos = 0;
+
+		tkn.clear();
+	}
 	catch (const exception& ex)
 	{
-		m_error = ex.what();
+		m_scanning = false;
+
+		// if the error was not thrown by this class (e.g. a decoder)
+		if (!has_error())
+		{
+			m_error = ex.what();
+
+			set_error(true);
+		}
 
 		error = true;
 	}
@@ -718,17 +2042,20 @@ bool scanner::get_token(token& tkn, bool& error)
 
 bool scanner::has_token(token& tkn)
 {
-	if (is_eof() || !*m_curpos)
+	if (is_eof() || m_curpos >= m_endpos)
 	{
 		return false;
 	}
 	else
 	{
-		while (isspace(*m_curpos))
+		m_read_directly = true;
+
+		// only the rest of the current line is examined
+		while (m_curpos < m_endpos && has_char_class((uint8_t)*m_curpos, cc_whitespace) && *m_curpos != '\n' && *m_curpos != '\r')
 		{
 			++m_curpos;
 		}
-		if (!*m_curpos || '%' == *m_curpos)
+		if (m_curpos >= m_endpos || !*m_curpos || '%' == *m_curpos || '\n' == *m_curpos || '\r' == *m_curpos)
 		{
 			return false;
 		}
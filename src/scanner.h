@@ -13,6 +13,12 @@
 
 #pragma once
 #include "data.h"
+#include "mapped-file.h"
+#include "dsc-index.h"
+#include <vector>
+
+class decode_filter;
+class read_ahead;
 
 struct token
 {
@@ -20,6 +26,9 @@ struct token
 	operand_type m_type{ operand_type::ot_null };
 	double m_number{ 0.0 };
 	string m_string;
+	// payload of names and strings; points into the mapped input when
+	// possible, otherwise into m_name or m_string. Valid until the next token
+	string_view m_view;
 	token() : m_string()
 	{
 		m_string.reserve(512);
@@ -30,12 +39,22 @@ struct token
 	void clear()
 	{
 		m_string.clear();
+		m_view = string_view();
 		m_type = operand_type::ot_null;
 		m_name[0] = 0;
 		m_number = 0.0;
 	}
 };
 
+// an object decoded from a binary object sequence or a homogeneous
+// number array; handed out by get_token() one at a time
+struct binary_object
+{
+	operand_type m_type{ operand_type::ot_null };
+	double m_number{ 0.0 };
+	string_view m_view;
+};
+
 class scanner : public common_class
 {
 	token* m_token{ nullptr };
@@ -44,12 +63,32 @@ class scanner : public common_class
 	int m_row{ 0 };
 	bool m_quit{ false };
 	char m_buffer[MAX_LINE_BUF + 1]{ 0 };
-	char* m_curpos{ nullptr };
+	mapped_file m_map;
+	const char* m_start{ nullptr }; // start of the current buffer or the mapped file
+	const char* m_curpos{ nullptr };
+	const char* m_endpos{ nullptr };
+	const char* m_line{ nullptr }; // start of the current line
 	bool m_eps{ false };
+	dsc_index m_dsc;
+	bool m_stable{ false }; // the buffer outlives the tokens (mapped file)
+	bool m_map_files{ true }; // false reads seekable files line by line
 	bool m_show_prompt{ true };
+	bool m_read_directly{ false }; // the program read tokens itself (currentfile token)
+	vector<binary_object> m_binary_objects;
+	size_t m_binary_pos{ 0 };
+	string m_binary_data; // copy of a binary object sequence when the input is not mapped
+	decode_filter* m_filter{ nullptr }; // owned; the input of a filter scanner
+	read_ahead* m_reader{ nullptr }; // owned; streams and pipes
+	string m_data; // the data read from m_filter, from the current chunk on
+	size_t m_data_end{ 0 }; // the end of the current chunk; the rest waits for more data
+	string m_pending; // fed data from the start of the current token on (push mode)
+	bool m_input_ended{ false };
+	bool m_needs_input{ false };
+	bool m_scanning{ false }; // inside get_token()
 	void do_comment();
 	bool is_delimiter(uint8_t ch);
 	size_t get_name(char* buf, size_t buf_len);
+	string_view get_name(size_t max_len);
 	void read_name();
 	void do_name();
 	void do_literal();
@@ -60,25 +99,35 @@ class scanner : public common_class
 	void do_angular_off();
 	void do_hex_string_on();
 	void do_text_string_on();
+	bool peek_string_char(uint8_t& ch);
+	void do_string_escape(string& str);
 	void do_tilde();
+	void do_ascii85_string();
+	void decode_ascii85(string& out);
+	void read_binary(uint8_t* buf, size_t len);
+	string_view read_binary_view(size_t len);
+	void add_binary_object(operand_type type, double number = 0.0, string_view view = string_view());
+	void do_binary_token(uint8_t ch);
+	void do_binary_array(uint8_t ch);
+	void do_binary_sequence(uint8_t ch);
+	void decode_binary_object(const uint8_t* objects, size_t len, size_t offset, bool low_first, bool ieee, int depth);
 	void get_token_ex(token& tkn);	
 	bool (scanner::*read_file_ptr)();
 	bool read_file();
 	bool read_stdin();
-	bool find_bounding_box(double& width, double& height);
+	bool read_mapped();
+	bool read_filter();
+	bool read_block();
+	bool read_fed();
+	void set_fed_buffer();
+	void set_buffer(const char* start, size_t len);
+	void index_file();
+	bool start_inflate();
 public:
-	scanner() : common_class(), m_curpos(m_buffer), read_file_ptr(&scanner::read_stdin)
+	scanner() : common_class(), m_start(m_buffer), m_curpos(m_buffer), m_endpos(m_buffer), m_line(m_buffer), m_binary_objects(), m_binary_data(), m_data(), m_pending(), read_file_ptr(&scanner::read_stdin)
 	{
 	}
-	~scanner()
-	{
-		clear();
-
-		if (m_file && m_file != stdin)
-		{
-			fclose(m_file);
-		}
-	}
+	~scanner();
 	void clear();
 	bool get_token(token& tkn, bool& error);
 	bool has_token(token& tkn);
@@ -88,8 +137,38 @@ public:
 	uint8_t get();
 	uint8_t peek() const;
 	bool load_file(const char* input_file, double &width, double &height);
+	void map_files(bool value)
+	{
+		m_map_files = value;
+	}
+	void load_filter(decode_filter* filter);
+	string_view read_raw();
+	void skip_raw(size_t len);
 	bool is_interactive() const;
 	bool is_eof() const;
 	bool is_eps() const;
+	const dsc_index& dsc() const
+	{
+		return m_dsc;
+	}
+	// for input that is not scanned (token cache)
+	void load_dsc(const dsc_index& dsc)
+	{
+		m_dsc = dsc;
+		m_eps = m_dsc.m_has_bounding_box;
+	}
+	bool read_directly() const
+	{
+		return m_read_directly;
+	}
 	void clear_input();
+	// Push mode: the input is handed over in chunks instead of being read from a file.
+	// get_token() returns false with needs_input() set when a token continues past the
+	// data fed so far; it is scanned again after the next feed() or end_input()
+	void feed(const char* data, size_t len);
+	void end_input();
+	bool needs_input() const
+	{
+		return m_needs_input;
+	}
 };
\ No newline at end of file
@@ -22,10 +22,7 @@ void processor::pop(size_t count)
 	}
 	else
 	{
-		for (size_t i = 0; i < count; ++i)
-		{
-			m_operand_stack.pop_front();
-		}
+		m_operand_stack.pop(count);
 	}
 }
 
@@ -36,14 +33,26 @@ void processor::pop()
 
 void processor::push_operand(operand& op)
 {
-		m_operand_stack.push_front(op);
+	m_operand_stack.push(op);
 }
 
-void processor::push_type(operand_type type)
+void processor::push_operand(operand&& op)
 {
-	operand op(type);
+	m_operand_stack.push(std::move(op));
+}
+
+operand processor::pop_operand()
+{
+	if (m_operand_stack.empty())
+	{
+		message("Stack underflow");
+	}
+	return m_operand_stack.take();
+}
 
-	push_operand(op);
+void processor::push_type(operand_type type)
+{
+	push_operand(operand(type));
 }
 
 void processor::push_number(double number, operand_type type)
@@ -52,21 +61,19 @@ void processor::push_number(double number, operand_type type)
 
 	op.m_number = number;
 
-	push_operand(op);
+	push_operand(std::move(op));
 }
 
-void processor::push_name(const char* name, int32_t len, operand_type type)
+void processor::push_name(atom name, operand_type type)
 {
-	string_type* str;
+	push_operand(operand(name, type));
+}
+
+// the string is copied here because the object outlives the input buffer
+void processor::push_string(string_view name, operand_type type)
+{
+	string_type* str = new string_type(name.data(), name.size(), type);
 
-	if (len < 0)
-	{
-		str = new string_type(name, type);
-	}
-	else
-	{
-		str = new string_type(name, (size_t)len, type);
-	}
 	if (!str)
 	{
 		message("Not enough memory to allocate a string object");
@@ -77,29 +84,20 @@ void processor::push_name(const char* name, int32_t len, operand_type type)
 
 		op.m_object = str;
 
-		push_operand(op);
+		push_operand(std::move(op));
 	}
 }
 
-void processor::push_string(const string& str, operand_type type)
-{
-	const char* data = str.data();
-	int32_t len = (int32_t)str.length();
-
-	push_name(data, len, type);
-}
-
 int32_t processor::counttomark()
 {
-	int32_t i = 0;
+	size_t count = m_operand_stack.size();
 
-	for (const auto& o : m_operand_stack)
+	for (size_t i = 0; i < count; ++i)
 	{
-		if (o.is_marker_on())
+		if (m_operand_stack[i].is_marker_on())
 		{
-			return i;
+			return (int32_t)i;
 		}
-		++i;
 	}
 
 	return NOTFOUND;
@@ -118,7 +116,13 @@ void processor::create_array(operand_type type)
 	}
 	else
 	{
-		array_type *arr = new array_type(index, type);
+		// the procedures of the prolog are usually kept for the whole job. Only those
+		// scanned from the main input go to the arena: each is scanned once, so without
+		// %%EndProlog or %%Page the arena is still bounded by the size of the input.
+		// Procedures from filters and 'token' may be built over and over in a loop,
+		// so they are reference counted
+		bool permanent = ot_procedure == type && m_in_prolog && 0 == m_nested_input;
+		array_type *arr = permanent ? create_permanent<array_type>((size_t)index, type) : new array_type(index, type);
 
 		if (!arr)
 		{
@@ -136,21 +140,18 @@ void processor::create_array(operand_type type)
 			}
 			for (int32_t i = 0, slot = index-1; i < index; ++i, --slot)
 			{
-				operand& tmp = m_operand_stack[i];
-
-				arr->put(slot, tmp);
-				
+				arr->put(slot, std::move(m_operand_stack[i]));
 			}
 			// remove the items and marker from the stack
 
 			pop(index + 1);
 
-			push_operand(op);
+			push_operand(std::move(op));
 		}
 	}
 }
 
-void processor::do_copy(operator_handler* handler)
+void processor::do_copy(const operator_handler* handler)
 {
 	operand& op = m_operand_stack[0];
 
@@ -167,29 +168,18 @@ void processor::do_copy(operator_handler* handler)
 		{
 			message("Stack underflow in --copy--. Parameter(s) required: %u. Stack size: %u", count, stack_size);
 		}
-		m_operand_stack.pop_front();
+		pop();
 
-		for (size_t i = 0, index = count - 1; i < count; ++i)
-		{
-			operand& tmp = m_operand_stack[index];
-			
-			push_operand(tmp);
-		}
+		m_operand_stack.copy(count);
 	}
 }
 
 void processor::do_exch()
 {
-	operand op = m_operand_stack[0];
-	operand op2 = m_operand_stack[1];
-
-	pop(2);
-
-	push_operand(op);
-	push_operand(op2);
+	std::swap(m_operand_stack[0], m_operand_stack[1]);
 }
 
-void processor::do_stack_ops(operator_handler* handler)
+void processor::do_stack_ops(const operator_handler* handler)
 {
 	switch (handler->m_op_id)
 	{
@@ -204,7 +194,7 @@ void processor::do_stack_ops(operator_handler* handler)
 		do_exch();
 		break;
 	case op_id_pop:
-		m_operand_stack.pop_front();
+		pop();
 		break;
 	case op_id_clear:
 		m_operand_stack.clear();
@@ -274,12 +264,12 @@ void processor::do_stack_ops(operator_handler* handler)
 }
 
 
-void processor::do_pstack(operator_handler* handler)
+void processor::do_pstack(const operator_handler* handler)
 {
 	dump_stack();
 }
 
-void processor::do_print_n_pop(operator_handler* handler)
+void processor::do_print_n_pop(const operator_handler* handler)
 {
 	operand& op = m_operand_stack[0];
 
@@ -288,12 +278,12 @@ void processor::do_print_n_pop(operator_handler* handler)
 	pop();
 }
 
-void processor::do_pop(operator_handler* handler)
+void processor::do_pop(const operator_handler* handler)
 {
 	pop();
 }
 
-void processor::do_roll(operator_handler* handler)
+void processor::do_roll(const operator_handler* handler)
 {
 	int32_t times;
 	size_t count;
@@ -321,33 +311,11 @@ void processor::do_roll(operator_handler* handler)
 
 	pop(2);
 
-	if (count > 0 && times != 0)
-	{
-		int32_t index = (int32_t)(stack_size() - count);
-
-		if (times > 0)
-		{
-			for (int32_t i = 0; i < times; ++i)
-			{
-				std::rotate(m_operand_stack.begin(), m_operand_stack.begin() + 1, m_operand_stack.end() - index);
-			}
-		}
-		else if (times < 0)
-		{
-			int32_t next = index + 1;
-
-			times = abs(times);
-
-			for (int32_t i = 0; i < times; ++i)
-			{
-				std::rotate(m_operand_stack.rbegin() + index, m_operand_stack.rbegin() + next, m_operand_stack.rend());
-			}
-		}
-	}
+	m_operand_stack.roll(count, times);
 }
 
 
-void processor::do_aload(operator_handler* handler)
+void processor::do_aload(const operator_handler* handler)
 {
 	if (m_operand_stack[0].is_array())
 	{
@@ -368,13 +336,13 @@ void processor::do_aload(operator_handler* handler)
 	}
 }
 
-void processor::do_print_top_stack(operator_handler* handler)
+void processor::do_print_top_stack(const operator_handler* handler)
 {
 	cout << m_operand_stack[0] << endl;
 	pop();
 }
 
-void processor::do_stack(operator_handler* handler)
+void processor::do_stack(const operator_handler* handler)
 {
 	for (auto& op : m_operand_stack)
 	{
@@ -389,14 +357,7 @@ void processor::do_stack(operator_handler* handler)
 		case ot_literal:
 		case ot_name:
 		case ot_text_string:
-			{
-				string_type *str = dynamic_cast<string_type*>(op.m_object);
-
-				if (str)
-				{
-					cout << str->data() << endl;
-				}
-			}
+			cout << op.string_value() << endl;
 			break;
 		default:
 			cout << "--nostringval--\n";
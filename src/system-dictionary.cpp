@@ -24,7 +24,8 @@ struct operator_handler
 	void (processor::* func)(const char *name, short m_param_count, operator_id m_op_id);
 };
 */
-static operator_handler handlers[] =
+// sorted by name; the index of an entry is the atom of its name (see builtin_name_index)
+static constexpr operator_handler handlers[] =
 {
 	{"=",  1, false, op_id_print_top_stack,&processor::do_print_top_stack },
 	{"==",  1, false, op_id_print_n_pop,&processor::do_print_n_pop },
@@ -83,13 +84,13 @@ static operator_handler handlers[] =
 	{"exit",  0, false, op_id_exit,&processor::do_misc_ops },
 	{"exp", 1, true, op_id_exp,&processor::do_math_binary_ops},
 	{"fill", 0, false, op_id_fill,&processor::do_path_ops},
+	{"filter", 2, false, op_id_filter,&processor::do_filter},
 	{"findfont",  1, false, op_id_findfont,&processor::do_findfont },
 	{"flattenpath",  0, false, op_id_flattenpath,&processor::do_flattenpath},
 	{"floor", 1, true, op_id_floor,&processor::do_math_unary_ops},
 	{"for",  4, false, op_id_for,&processor::do_for },
 	{"ge",  2, false, op_id_ge,&processor::do_ge},
 	{"get",  2, false, op_id_get,&processor::do_get },
-	{"get",  2, false, op_id_get,&processor::do_get},
 	{"grestore",  0, false, op_id_grestore,&processor::do_grestore },
 	{"gsave",  0, false, op_id_gsave,&processor::do_gsave },
 	{"gt",  2, false, op_id_gt,&processor::do_gt},
@@ -175,84 +176,147 @@ static operator_handler handlers[] =
 
 };
 
-static int compare_name(const void* s1, const void* s2)
-{
-	const operator_handler* p1 = (operator_handler*)s1;
-	const operator_handler* p2 = (operator_handler*)s2;
+// names of the system dictionary that are not operators; they follow the operators
+static constexpr const char* system_values[] = { "true", "false", "null" };
 
-	return strcmp(p1->m_name, p2->m_name);
-}
+static constexpr size_t system_count = array_size(handlers) + array_size(system_values);
 
-operator_handler* processor::search_operator_dictionary(const char* name)
+static constexpr string_view get_system_name(size_t index)
 {
-	size_t table_size = array_size(handlers);
-	operator_handler key = { name, 0, false, op_id_null, nullptr };
-	
+	return index < array_size(handlers) ? handlers[index].m_name : system_values[index - array_size(handlers)];
+}
 
-	return (operator_handler*)bsearch(&key, handlers, table_size, sizeof(handlers[0]), compare_name);	
+static constexpr bool is_sorted_and_unique()
+{
+	for (size_t i = 1; i < array_size(handlers); ++i)
+	{
+		if (string_view(handlers[i - 1].m_name) >= string_view(handlers[i].m_name))
+		{
+			return false;
+		}
+	}
+	return true;
 }
 
-bool processor::search_system_dictionary(const char* name, operand& value)
+static_assert(is_sorted_and_unique(), "The operator table must be sorted by name, without duplicates");
+static_assert(system_count < 255, "The system names don't fit in the perfect hash slots");
+
+// Perfect hash of the system names, generated at compile time: the first seed for
+// which no two names share a slot. A lookup is one hash and one compare
+
+#define SYSTEM_HASH_SIZE 4096
+
+struct system_hash_table
 {
-	operator_handler* h = search_operator_dictionary(name);
+	uint32_t m_seed{ 0 };
+	uint8_t m_slot[SYSTEM_HASH_SIZE]{ 0 }; // index + 1 of the name; 0 if empty
+};
 
-	if (h)
-	{
-		value.m_type = ot_operator;
-		value.m_operator = h;
+static constexpr uint32_t hash_system_name(string_view name, uint32_t seed)
+{
+	uint32_t hash = 2166136261u ^ seed;
 
-		return true;
+	for (char ch : name)
+	{
+		hash ^= (uint8_t)ch;
+		hash *= 16777619u;
 	}
-	else
+
+	return (hash ^ (hash >> 15)) & (SYSTEM_HASH_SIZE - 1);
+}
+
+static constexpr system_hash_table build_system_hash()
+{
+	for (uint32_t seed = 1; ; ++seed)
 	{
-		switch (*name)
+		system_hash_table table{};
+		bool collision = false;
+
+		table.m_seed = seed;
+
+		for (size_t i = 0; i < system_count && !collision; ++i)
 		{
-		case 'f':
-			if (strcmp(name, "false") == 0)
-			{
-				value.m_type = ot_boolean;
-				value.m_bool = false;
-				return true;
-			}
-			break;
-		case 't':
-			if (strcmp(name, "true") == 0)
+			uint32_t slot = hash_system_name(get_system_name(i), seed);
+
+			if (table.m_slot[slot])
 			{
-				value.m_type = ot_boolean;
-				value.m_bool = true;
-				return true;
+				collision = true;
 			}
-			break;
-		case 'n':
-			if (strcmp(name, "null") == 0)
+			else
 			{
-				value.m_type = ot_null;
-				value.m_dummy = 0;
-				return true;
+				table.m_slot[slot] = (uint8_t)(i + 1);
 			}
-			break;
 		}
+		if (!collision)
+		{
+			return table;
+		}
+	}
+}
+
+static constexpr system_hash_table system_hash = build_system_hash();
+
+int builtin_name_index(string_view name)
+{
+	int slot = system_hash.m_slot[hash_system_name(name, system_hash.m_seed)];
+
+	if (slot && get_system_name(slot - 1) == name)
+	{
+		return slot - 1;
+	}
+	return NOTFOUND;
+}
+
+string_view builtin_name(atom id)
+{
+	return get_system_name(id);
+}
+
+atom builtin_name_count()
+{
+	return (atom)system_count;
+}
+
+// the atom of a system name is its index (see name_table::intern)
+
+bool processor::search_system_dictionary(atom name, operand& value)
+{
+	size_t operator_count = array_size(handlers);
+
+	if (name >= system_count)
+	{
 		return false;
 	}
+
+	value.clear();
+
+	if (name < operator_count)
+	{
+		value.m_type = ot_operator;
+		value.m_operator = &handlers[name];
+	}
+	else if (name < operator_count + 2)
+	{
+		// true, false
+		value.m_type = ot_boolean;
+		value.m_bool = (name == operator_count);
+	}
+
+	return true;
 }
 
-bool processor::find_key(const char* name, operand& value)
+bool processor::find_key(atom name, operand& value)
 {
 	return search_system_dictionary(name, value);
 }
 
 bool processor::find_key(const operand& key, operand& value)
 {
-	if (key.is_string_type())
-	{
-		const string_type* str = dynamic_cast<string_type*>(key.m_object);
+	atom name;
 
-		if (str)
-		{
-			const char* name = str->data();
-
-			return search_system_dictionary(name, value);
-		}
+	if (key.key_atom(name))
+	{
+		return search_system_dictionary(name, value);
 	}
 
 	return false;
@@ -0,0 +1,360 @@
+/*
+//  Copyright (c) 2020 Peter Frane Jr. All Rights Reserved.
+//
+//  Use of this source code is governed by the GPL v. 3.0 license that can be
+//  found in the LICENSE file.
+//
+//  This software is distributed on an "AS IS" basis, WITHOUT WARRANTY
+//  OF ANY KIND, either express or implied.
+//
+//  For inquiries, email the author at pfranejr AT hotmail.com
+*/
+
+#include "token-cache.h"
+#include <cstring>
+
+/*
+* File layout (native byte order):
+*
+* header      magic[8], hash (u64), input size (u64), name count (u32), token count (u32)
+* names       length (u16), characters
+* tokens      type (u8), followed by
+*               integer:            value (i32)
+*               real:               value (f64)
+*               name/literal/const: name index (u32)
+*               string/dsc:         length (u32), characters
+*               markers:            nothing
+*/
+
+static const char cache_magic[8] = { 'E', 'P', 'S', 'T', 'K', 'C', '0', '2' };
+
+struct cache_header
+{
+	char m_magic[8];
+	uint64_t m_hash;
+	uint64_t m_input_size;
+	uint32_t m_name_count;
+	uint32_t m_token_count;
+};
+
+// 64-bit FNV-1a
+static uint64_t hash_data(const char* data, size_t len)
+{
+	uint64_t hash = 14695981039346656037ULL;
+
+	for (size_t i = 0; i < len; ++i)
+	{
+		hash ^= (uint8_t)data[i];
+		hash *= 1099511628211ULL;
+	}
+
+	return hash;
+}
+
+bool token_cache::open(const char* input_file)
+{
+	mapped_file input;
+
+	if (!input.open(input_file))
+	{
+		return false;
+	}
+
+	m_hash = hash_data(input.data(), input.size());
+	m_input_size = input.size();
+
+	// the same index as load_file(), so '(atend)' comments resolve as in a scan
+	m_dsc.build(input.data(), input.size());
+
+	m_cache_file = input_file;
+	m_cache_file.append(".tkc");
+
+	return true;
+}
+
+bool token_cache::load()
+{
+	cache_header header;
+
+	if (!m_map.open(m_cache_file.c_str()))
+	{
+		return false;
+	}
+
+	m_curpos = m_map.data();
+	m_endpos = m_curpos + m_map.size();
+
+	if (!read(&header, sizeof(header)) || memcmp(header.m_magic, cache_magic, sizeof(cache_magic)) != 0
+		|| header.m_hash != m_hash || header.m_input_size != m_input_size)
+	{
+		// stale or foreign; it will be replaced
+		m_map.close();
+
+		return false;
+	}
+
+	m_names.clear();
+	m_names.reserve(header.m_name_count);
+
+	for (uint32_t i = 0; i < header.m_name_count; ++i)
+	{
+		uint16_t len;
+		string_view name;
+
+		if (!read(&len, sizeof(len)) || !read_view(name, len))
+		{
+			m_map.close();
+
+			return false;
+		}
+
+		m_names.push_back(name);
+	}
+
+	m_remaining = header.m_token_count;
+
+	return true;
+}
+
+bool token_cache::read(void* data, size_t len)
+{
+	if ((size_t)(m_endpos - m_curpos) < len)
+	{
+		return false;
+	}
+
+	memcpy(data, m_curpos, len);
+
+	m_curpos += len;
+
+	return true;
+}
+
+bool token_cache::read_view(string_view& view, size_t len)
+{
+	if ((size_t)(m_endpos - m_curpos) < len)
+	{
+		return false;
+	}
+
+	view = string_view(m_curpos, len);
+
+	m_curpos += len;
+
+	return true;
+}
+
+// the views in 'tkn' point into the mapped cache file
+
+bool token_cache::next(token& tkn)
+{
+	uint8_t type;
+
+	tkn.clear();
+
+	if (0 == m_remaining)
+	{
+		return false;
+	}
+	if (!read(&type, sizeof(type)))
+	{
+		message("Token cache is truncated: %s", m_cache_file.c_str());
+	}
+
+	tkn.m_type = (operand_type)type;
+
+	switch (tkn.m_type)
+	{
+	case ot_integer:
+		{
+			int32_t value;
+
+			if (!read(&value, sizeof(value)))
+			{
+				message("Token cache is truncated: %s", m_cache_file.c_str());
+			}
+			tkn.m_number = value;
+		}
+		break;
+	case ot_real:
+		if (!read(&tkn.m_number, sizeof(tkn.m_number)))
+		{
+			message("Token cache is truncated: %s", m_cache_file.c_str());
+		}
+		break;
+	case ot_constant:
+	case ot_literal:
+	case ot_name:
+		{
+			uint32_t index;
+
+			if (!read(&index, sizeof(index)) || index >= m_names.size())
+			{
+				message("Invalid name in token cache: %s", m_cache_file.c_str());
+			}
+			tkn.m_view = m_names[index];
+		}
+		break;
+	case ot_dsc:
+	case ot_hex_string:
+	case ot_text_string:
+		{
+			uint32_t len;
+
+			if (!read(&len, sizeof(len)) || !read_view(tkn.m_view, len))
+			{
+				message("Token cache is truncated: %s", m_cache_file.c_str());
+			}
+			if (ot_dsc == tkn.m_type)
+			{
+				// processor::read_dsc() expects a string
+				tkn.m_string.assign(tkn.m_view.data(), tkn.m_view.size());
+			}
+		}
+		break;
+	case ot_array_marker_on:
+	case ot_array_marker_off:
+	case ot_dictionary_marker_on:
+	case ot_dictionary_marker_off:
+	case ot_procedure_marker_on:
+	case ot_procedure_marker_off:
+		break;
+	default:
+		message("Invalid token type in token cache: %d", type);
+		break;
+	}
+
+	--m_remaining;
+
+	return true;
+}
+
+uint32_t token_cache::intern(string_view name)
+{
+	auto it = m_name_index.find(name);
+
+	if (it != m_name_index.end())
+	{
+		return it->second;
+	}
+	else
+	{
+		uint32_t index = (uint32_t)m_name_list.size();
+
+		it = m_name_index.emplace(string(name), index).first;
+
+		m_name_list.push_back(&it->first);
+
+		return index;
+	}
+}
+
+void token_cache::record(const token& tkn)
+{
+	uint8_t type = (uint8_t)tkn.m_type;
+
+	switch (tkn.m_type)
+	{
+	case ot_null:
+	case ot_comment:
+		return;
+	case ot_integer:
+		{
+			int32_t value = (int32_t)tkn.m_number;
+
+			m_tokens.append((const char*)&type, sizeof(type));
+			m_tokens.append((const char*)&value, sizeof(value));
+		}
+		break;
+	case ot_real:
+		m_tokens.append((const char*)&type, sizeof(type));
+		m_tokens.append((const char*)&tkn.m_number, sizeof(tkn.m_number));
+		break;
+	case ot_constant:
+	case ot_literal:
+	case ot_name:
+		{
+			uint32_t index = intern(tkn.m_view);
+
+			m_tokens.append((const char*)&type, sizeof(type));
+			m_tokens.append((const char*)&index, sizeof(index));
+		}
+		break;
+	case ot_dsc:
+	case ot_hex_string:
+	case ot_text_string:
+		{
+			string_view str = (ot_dsc == tkn.m_type) ? string_view(tkn.m_string) : tkn.m_view;
+			uint32_t len = (uint32_t)str.size();
+
+			m_tokens.append((const char*)&type, sizeof(type));
+			m_tokens.append((const char*)&len, sizeof(len));
+			m_tokens.append(str.data(), str.size());
+		}
+		break;
+	default:
+		m_tokens.append((const char*)&type, sizeof(type));
+		break;
+	}
+
+	++m_token_count;
+}
+
+bool token_cache::save()
+{
+	cache_header header;
+	FILE* file;
+	bool result = true;
+
+	if (m_cache_file.empty())
+	{
+		return false;
+	}
+
+	file = fopen(m_cache_file.c_str(), "wb");
+
+	if (!file)
+	{
+		m_error = "Unable to create the token cache: ";
+
+		m_error.append(m_cache_file);
+
+		return false;
+	}
+
+	memcpy(header.m_magic, cache_magic, sizeof(cache_magic));
+
+	header.m_hash = m_hash;
+	header.m_input_size = m_input_size;
+	header.m_name_count = (uint32_t)m_name_list.size();
+	header.m_token_count = m_token_count;
+
+	result = fwrite(&header, sizeof(header), 1, file) == 1;
+
+	for (size_t i = 0; result && i < m_name_list.size(); ++i)
+	{
+		const string* name = m_name_list[i];
+		uint16_t len = (uint16_t)name->size();
+
+		result = fwrite(&len, sizeof(len), 1, file) == 1 && fwrite(name->data(), 1, len, file) == len;
+	}
+
+	if (result && !m_tokens.empty())
+	{
+		result = fwrite(m_tokens.data(), 1, m_tokens.size(), file) == m_tokens.size();
+	}
+
+	fclose(file);
+
+	if (!result)
+	{
+		// don't leave a partial cache behind
+		remove(m_cache_file.c_str());
+
+		m_error = "Unable to write the token cache: ";
+
+		m_error.append(m_cache_file);
+	}
+
+	return result;
+}
@@ -0,0 +1,58 @@
+/*
+//  Copyright (c) 2020 Peter Frane Jr. All Rights Reserved.
+//
+//  Use of this source code is governed by the GPL v. 3.0 license that can be
+//  found in the LICENSE file.
+//
+//  This software is distributed on an "AS IS" basis, WITHOUT WARRANTY
+//  OF ANY KIND, either express or implied.
+//
+//  For inquiries, email the author at pfranejr AT hotmail.com
+*/
+
+#pragma once
+#include "scanner.h"
+#include <vector>
+
+// The token stream of an input file, saved next to it as 'input_file.tkc'.
+// A later run with the same input (same content hash) replays the tokens
+// into processor::process_token instead of scanning the file again.
+
+class token_cache : public common_class
+{
+	string m_cache_file;
+	uint64_t m_hash{ 0 };
+	uint64_t m_input_size{ 0 };
+	dsc_index m_dsc; // of the input; replaying doesn't scan it
+	// recording
+	string m_tokens;
+	uint32_t m_token_count{ 0 };
+	map<string, uint32_t, less<>> m_name_index;
+	vector<const string*> m_name_list;
+	// replaying
+	mapped_file m_map;
+	vector<string_view> m_names;
+	const char* m_curpos{ nullptr };
+	const char* m_endpos{ nullptr };
+	uint32_t m_remaining{ 0 };
+
+	uint32_t intern(string_view name);
+	bool read(void* data, size_t len);
+	bool read_view(string_view& view, size_t len);
+public:
+	token_cache() : common_class(), m_cache_file(), m_dsc(), m_tokens(), m_name_index(), m_name_list(), m_map(), m_names()
+	{
+	}
+	~token_cache()
+	{
+	}
+	bool open(const char* input_file);
+	const dsc_index& dsc() const
+	{
+		return m_dsc;
+	}
+	bool load();
+	bool next(token& tkn);
+	void record(const token& tkn);
+	bool save();
+};
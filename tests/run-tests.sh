@@ -0,0 +1,74 @@
+#!/bin/sh
+#
+# usage: run-tests.sh path/to/eps2img
+#
+# Converts each test file in this directory by name, line by line (-nomap),
+# from the standard input and, unless compressed, in chunks of a few bytes
+# (-feed, push mode), and compares the output with the .expected file of the same
+# name (without the extensions). Compressed files (.gz) are read as they are.
+# quit.ps is also read from a pipe that stays open after it.
+# A .options file of the same name holds more options for eps2img. A debug
+# build (_DEBUG) also checks every object_cast against the actual class, and an
+# AddressSanitizer build checks that nothing leaks (see cycles.ps).
+
+if [ $# -ne 1 ]; then
+	echo "usage: $0 path/to/eps2img"
+	exit 2
+fi
+
+program=$(cd "$(dirname "$1")" && pwd)/$(basename "$1")
+output=test-output.pdf
+failed=0
+
+cd "$(dirname "$0")" || exit 2
+
+check()
+{
+	if [ "$2" != "$(cat "$3")" ]; then
+		echo "FAIL: $1"
+		printf '%s\n' "$2" | diff "$3" - | head -20
+		failed=1
+	fi
+}
+
+for file in *.ps *.eps *.gz; do
+	[ -f "$file" ] || continue
+
+	expected=${file%%.*}.expected
+	options=$(cat "${file%%.*}.options" 2>/dev/null)
+
+	check "$file" "$("$program" $options "$file" $output 2>/dev/null)" "$expected"
+	check "$file (-nomap)" "$("$program" $options -nomap "$file" $output 2>/dev/null)" "$expected"
+	check "$file (standard input)" "$("$program" $options - $output < "$file" 2>/dev/null)" "$expected"
+
+	case "$file" in
+	*.gz)
+		;;
+	*)
+		check "$file (-feed 7)" "$("$program" $options -feed 7 "$file" $output 2>/dev/null)" "$expected"
+		;;
+	esac
+done
+
+# quit.ps again from a pipe whose writer stays open: quit must not wait for it
+fifo=test-input.fifo
+rm -f $fifo
+mkfifo $fifo
+(cat quit.ps; exec sleep 10) > $fifo 2>/dev/null &
+writer=$!
+start=$(date +%s)
+check "quit.ps (open pipe)" "$("$program" - $output < $fifo 2>/dev/null)" quit.expected
+if [ $(($(date +%s) - start)) -ge 5 ]; then
+	echo "FAIL: quit.ps (open pipe) waited for the writer"
+	failed=1
+fi
+kill $writer 2>/dev/null
+rm -f $fifo
+
+rm -f $output
+
+if [ $failed -eq 0 ]; then
+	echo "All tests passed"
+fi
+
+exit $failed